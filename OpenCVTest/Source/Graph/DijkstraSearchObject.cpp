@@ -3,6 +3,8 @@
 #include "DijkstraSearchObject.h"
 #include "Graph/GraphTypes.h"
 #include "Graph/GraphHelpers.h"
+#include "Graph/PriorityQueue.h"
+#include "Graph/SearchWorkspace.h"
 
 DijkstraSearchObject::DijkstraSearchObject(const Graph& graph, std::vector<VertexInfo>& vertexInfo, vertIndex startIndex, DijkstraBitFlags flags)
     : DijkstraSearchObject( graph, vertexInfo, startIndex, -1, flags )
@@ -20,148 +22,274 @@ DijkstraSearchObject::DijkstraSearchObject(const Graph& graph, std::vector<Verte
 }
 
 DijkstraSearchObject::DijkstraSearchObject(const Graph& graph, std::vector<VertexInfo>& vertexInfo, std::vector<vertIndex> startIndices, vertIndex endIndex, DijkstraBitFlags flags)
-    : m_Graph( graph )
+    : m_pGraph( &graph )
+    , m_pCSRGraph( nullptr )
     , m_VertexInfo( vertexInfo )
     , m_EndIndex( endIndex )
     , m_Flags( flags )
     , m_MaxWeight( FLT_MAX )
+    , m_HeuristicScale( -1.0f )
+    , m_pWorkspace( nullptr )
 {
     m_StartIndices = startIndices;
 }
 
+DijkstraSearchObject::DijkstraSearchObject(const CSRGraph& graph, std::vector<VertexInfo>& vertexInfo, vertIndex startIndex, DijkstraBitFlags flags)
+    : DijkstraSearchObject( graph, vertexInfo, startIndex, -1, flags )
+{
+}
+
+DijkstraSearchObject::DijkstraSearchObject(const CSRGraph& graph, std::vector<VertexInfo>& vertexInfo, std::vector<vertIndex> startIndices, DijkstraBitFlags flags)
+    : DijkstraSearchObject( graph, vertexInfo, startIndices, -1, flags )
+{
+}
+
+DijkstraSearchObject::DijkstraSearchObject(const CSRGraph& graph, std::vector<VertexInfo>& vertexInfo, vertIndex startIndex, vertIndex endIndex, DijkstraBitFlags flags)
+    : DijkstraSearchObject( graph, vertexInfo, std::vector<vertIndex>(1, startIndex), endIndex, flags )
+{
+}
+
+DijkstraSearchObject::DijkstraSearchObject(const CSRGraph& graph, std::vector<VertexInfo>& vertexInfo, std::vector<vertIndex> startIndices, vertIndex endIndex, DijkstraBitFlags flags)
+    : m_pGraph( nullptr )
+    , m_pCSRGraph( &graph )
+    , m_VertexInfo( vertexInfo )
+    , m_EndIndex( endIndex )
+    , m_Flags( flags )
+    , m_MaxWeight( FLT_MAX )
+    , m_HeuristicScale( -1.0f )
+    , m_pWorkspace( nullptr )
+{
+    m_StartIndices = startIndices;
+}
+
+// Search state kept in the VertexInfo list, which has to be cleared for every vertex before each search.
+class VertexInfoSearchState
+{
+protected:
+    std::vector<VertexInfo>& m_VertexInfo;
+    IndexedPriorityQueue m_OpenList;
+
+public:
+    VertexInfoSearchState(std::vector<VertexInfo>& vertexInfo) : m_VertexInfo( vertexInfo ) {}
+
+    void BeginSearch(size_t numVerts)
+    {
+        for( size_t i=0; i<numVerts; i++ )
+        {
+            m_VertexInfo[i].closed = false;
+            m_VertexInfo[i].lowestWeight = FLT_MAX;
+            m_VertexInfo[i].parentIndex = -1;
+        }
+
+        m_OpenList.Reset( numVerts );
+    }
+
+    IndexedPriorityQueue& GetOpenList() { return m_OpenList; }
+
+    bool IsClosed(vertIndex v) const { return m_VertexInfo[v].closed; }
+    edgeWeight GetDistance(vertIndex v) const { return m_VertexInfo[v].lowestWeight; }
+    vertIndex GetParent(vertIndex v) const { return m_VertexInfo[v].parentIndex; }
+    treeIndex GetOwner(vertIndex v) const { return m_VertexInfo[v].owner; }
+
+    void SetClosed(vertIndex v) { m_VertexInfo[v].closed = true; }
+    void SetDistance(vertIndex v, edgeWeight distance) { m_VertexInfo[v].lowestWeight = distance; }
+    void SetParent(vertIndex v, vertIndex parent) { m_VertexInfo[v].parentIndex = parent; }
+};
+
+// Search state kept in a SearchWorkspace, nothing is cleared up front. Regions still come from the VertexInfo owners.
+class WorkspaceSearchState
+{
+protected:
+    SearchWorkspace& m_Workspace;
+    const std::vector<VertexInfo>& m_VertexInfo;
+
+public:
+    WorkspaceSearchState(SearchWorkspace& workspace, const std::vector<VertexInfo>& vertexInfo) : m_Workspace( workspace ), m_VertexInfo( vertexInfo ) {}
+
+    void BeginSearch(size_t numVerts) { m_Workspace.BeginSearch( numVerts ); }
+
+    IndexedPriorityQueue& GetOpenList() { return m_Workspace.GetOpenList(); }
+
+    bool IsClosed(vertIndex v) const { return m_Workspace.IsClosed( v ); }
+    edgeWeight GetDistance(vertIndex v) const { return m_Workspace.GetDistance( v ); }
+    vertIndex GetParent(vertIndex v) const { return m_Workspace.GetParent( v ); }
+    treeIndex GetOwner(vertIndex v) const { return m_VertexInfo[v].owner; }
+
+    void SetClosed(vertIndex v) { m_Workspace.SetClosed( v ); }
+    void SetDistance(vertIndex v, edgeWeight distance) { m_Workspace.SetDistance( v, distance ); }
+    void SetParent(vertIndex v, vertIndex parent) { m_Workspace.SetParent( v, parent ); }
+};
+
+// Only CSRGraph keeps the scale around, measuring it on a Graph would cost more than the search.
+static float GetDefaultHeuristicScale(const Graph&) { return 0; }
+static float GetDefaultHeuristicScale(const CSRGraph& graph) { return graph.minWeightPerDistance; }
+
 vertIndexList DijkstraSearchObject::Search()
+{
+    if( m_pWorkspace )
+    {
+        WorkspaceSearchState state( *m_pWorkspace, m_VertexInfo );
+        if( m_pCSRGraph )
+            return Search( *m_pCSRGraph, state );
+
+        return Search( *m_pGraph, state );
+    }
+
+    VertexInfoSearchState state( m_VertexInfo );
+    if( m_pCSRGraph )
+        return Search( *m_pCSRGraph, state );
+
+    return Search( *m_pGraph, state );
+}
+
+template<typename GraphType, typename StateType> vertIndexList DijkstraSearchObject::Search(const GraphType& graph, StateType& state)
 {
     vertIndexList connectedVerts;
 
-    if( m_Graph.neighbours.size() == 0 )
+    if( graph.GetVertexCount() == 0 )
         return connectedVerts;
 
-    // Init vertexInfo struct for each vertex.
-    for( size_t i=0; i<m_Graph.points.size(); i++ )
-    {
-        m_VertexInfo[i].closed = false;
-        m_VertexInfo[i].lowestWeight = FLT_MAX;
-    }
+    // Every vertex starts unvisited.
+    state.BeginSearch( graph.GetVertexCount() );
 
     if( m_pPostInitCallback != nullptr )
     {
         m_pPostInitCallback();
     }
 
+    bool checkWeights = (m_Flags & DBF_CheckWeights) != 0;
+    bool returnShortestPath = (m_Flags & DBF_ReturnShortestPath) != 0;
+
     // Open list.
-    pointIndexList openList = m_StartIndices;
-    if( (m_Flags & DBF_ReturnShortestPath) == 0 )
+    // Without weights this is a plain flood fill, so the open list is a stack.
+    // With weights it's a heap keyed on the lowest known weight for each vertex.
+    pointIndexList openStack;
+    IndexedPriorityQueue& openHeap = state.GetOpenList();
+
+    // With DBF_AStar the heap is keyed on the weight so far plus an estimate of the weight left to reach the end.
+    float heuristicScale = 0;
+    vec2 endPos;
+    if( checkWeights && returnShortestPath && (m_Flags & DBF_AStar) && m_EndIndex < graph.GetVertexCount() )
+    {
+        heuristicScale = m_HeuristicScale;
+        if( heuristicScale < 0 )
+        {
+            heuristicScale = m_pWeightCalculationCallback ? 0 : GetDefaultHeuristicScale( graph );
+        }
+        endPos = graph.points[m_EndIndex];
+    }
+
+    auto heuristic = [&](vertIndex v)
+    {
+        return heuristicScale == 0 ? 0.0f : heuristicScale * graph.points[v].DistanceFrom( endPos );
+    };
+
+    if( checkWeights )
+    {
+        for( vertIndex v : m_StartIndices )
+        {
+            openHeap.PushOrDecrease( v, heuristic( v ) );
+        }
+    }
+    else
+    {
+        openStack = m_StartIndices;
+    }
+
+    if( returnShortestPath == false )
     {
         connectedVerts.insert( connectedVerts.end(), m_StartIndices.begin(), m_StartIndices.end() );
     }
 
     for( vertIndex v : m_StartIndices )
     {
-        m_VertexInfo[v].lowestWeight = 0;
+        state.SetDistance( v, 0 );
     }
 
     // Loop until we've visited all neighbours,
     //    making a list of all verts connected to startIndex.
-    while( openList.size() > 0 )
+    while( checkWeights ? openHeap.IsEmpty() == false : openStack.size() > 0 )
     {
-        // Grab the last element of the open list, which is the lowest weight vertex.
-        vertIndex currentIndex = openList[openList.size()-1];
-        openList.pop_back();
-        m_VertexInfo[currentIndex].closed = true;
+        // Grab the lowest weight vertex, or the most recently added one when not checking weights.
+        vertIndex currentIndex;
+        if( checkWeights )
+        {
+            currentIndex = openHeap.PopMin();
+        }
+        else
+        {
+            currentIndex = openStack[openStack.size()-1];
+            openStack.pop_back();
+
+            // The stack can hold a vertex more than once, only expand it the first time.
+            if( state.IsClosed( currentIndex ) )
+                continue;
+        }
+        state.SetClosed( currentIndex );
 
         if( m_pVertexSelectedFromOpenListCallback != nullptr )
         {
             m_pVertexSelectedFromOpenListCallback( currentIndex );
         }
 
+        // Once the end vertex comes off the heap its cost is final, so there's no need to keep going.
+        if( checkWeights && returnShortestPath && currentIndex == m_EndIndex )
+            break;
+
         // Loop through neighbours.
-        for( const vertIndex nIndex : m_Graph.neighbours[currentIndex] )
+        for( const vertIndex nIndex : graph.GetNeighbours( currentIndex ) )
         {
             // If the neighbour is closed, skip over it.
-            if( m_VertexInfo[nIndex].closed )
+            if( state.IsClosed( nIndex ) )
                 continue;
 
             if( m_Flags & DijkstraBitFlags::DBF_ForceSameOwnership )
             {
                 // If the verts aren't part of the same region.
-                if( m_VertexInfo[nIndex].owner != m_VertexInfo[currentIndex].owner )
+                if( state.GetOwner( nIndex ) != state.GetOwner( currentIndex ) )
                     continue;
             }
 
             // Check weights.
-            if( (m_Flags & DijkstraBitFlags::DBF_CheckWeights) == 0 )
+            if( checkWeights == false )
             {
-                openList.push_back( nIndex );
-                if( (m_Flags & DBF_ReturnShortestPath) == 0 )
+                openStack.push_back( nIndex );
+                if( returnShortestPath == false )
                 {
                     connectedVerts.push_back( nIndex );
                 }
             }
             else
             {
-                vertIndex lowerIndex = currentIndex < nIndex ? currentIndex : nIndex;
-                vertIndex higherIndex = currentIndex > nIndex ? currentIndex : nIndex;
                 edgeWeight weight = 0;
                 if( m_pWeightCalculationCallback )
                 {
-                    weight = m_pWeightCalculationCallback( currentIndex, nIndex, m_VertexInfo[currentIndex].parentIndex );
+                    weight = m_pWeightCalculationCallback( currentIndex, nIndex, state.GetParent( currentIndex ) );
                 }
                 else
                 {
-                    weight = m_Graph.weights.at(lowerIndex).at(higherIndex);
+                    weight = graph.GetWeight( currentIndex, nIndex );
                 }
 
-                edgeWeight totalWeight = m_VertexInfo[currentIndex].lowestWeight + weight;
+                edgeWeight totalWeight = state.GetDistance( currentIndex ) + weight;
 
-                if( totalWeight < m_VertexInfo[nIndex].lowestWeight && totalWeight < m_MaxWeight )
+                if( totalWeight < state.GetDistance( nIndex ) && totalWeight < m_MaxWeight )
                 {
-                    m_VertexInfo[nIndex].lowestWeight = totalWeight;
-
-                    if( (m_Flags & DBF_ReturnShortestPath) == 0 )
+                    // Only list each vertex once, the first time it's reached.
+                    if( returnShortestPath == false && openHeap.Contains( nIndex ) == false )
                     {
                         connectedVerts.push_back( nIndex );
                     }
 
-                    // If we already have a parent, then we have an old cost which was higher.
-                    // Remove from open list and re-add it sorted in new position.
-                    if( m_VertexInfo[nIndex].parentIndex != -1 && m_VertexInfo[nIndex].closed == false )
-                    {
-                        auto it = std::find( openList.begin(), openList.end(), nIndex );
-                        if( it != openList.end() )
-                        {
-                            openList.erase( it );
-                        }
-                    }
-
-                    // Insert into open list sorted in descending order.
-                    {
-                        bool inserted = false;
-                        for( size_t i=0; i<openList.size(); i++ )
-                        {
-                            if( totalWeight > m_VertexInfo[openList[i]].lowestWeight )
-                            {
-                                inserted = true;
-                                openList.insert( openList.begin() + i, nIndex );
-                                break;
-                            }
-                        }
-
-                        // If the list was empty or we didn't find a shorter path,
-                        // insert the element at the end of the list.
-                        if( inserted == false )
-                        {
-                            openList.push_back( nIndex );
-                            if( (m_Flags & DBF_ReturnShortestPath) == 0 )
-                            {
-                                connectedVerts.push_back( nIndex );
-                            }
-                        }
-                    }
+                    state.SetDistance( nIndex, totalWeight );
 
                     // Set the new parent.
-                    m_VertexInfo[nIndex].parentIndex = currentIndex;
+                    state.SetParent( nIndex, currentIndex );
                     // Copy the owner over.
                     //m_VertexInfo[nIndex].owner = vertexInfo[currentIndex].owner;
+
+                    // Adds the vertex or moves it up the heap if it was already open with a higher cost.
+                    openHeap.PushOrDecrease( nIndex, totalWeight + heuristic( nIndex ) );
                 }
             }
         }
@@ -175,10 +303,10 @@ vertIndexList DijkstraSearchObject::Search()
         {
             path.push_back( i );
 
-            //if( m_VertexInfo[i].lowestWeight <= 0.0f )
+            //if( state.GetDistance( i ) <= 0.0f )
             //    break;
 
-            i = m_VertexInfo[i].parentIndex;
+            i = state.GetParent( i );
         }
         return path;
     }
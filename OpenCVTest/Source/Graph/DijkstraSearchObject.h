@@ -4,6 +4,8 @@
 #include "Graph/GraphTypes.h"
 
 class Graph;
+class CSRGraph;
+class SearchWorkspace;
 
 class DijkstraSearchObject
 {
@@ -19,6 +21,7 @@ public:
         DBF_ForceSameOwnership  = 0x01,
         DBF_CheckWeights        = 0x02,
         DBF_ReturnShortestPath  = 0x04,
+        DBF_AStar               = 0x08, // Needs DBF_CheckWeights and DBF_ReturnShortestPath, guides the search toward m_EndIndex.
     };
 
 public:
@@ -26,10 +29,19 @@ public:
     DijkstraSearchObject(const Graph& graph, std::vector<VertexInfo>& vertexInfo, std::vector<vertIndex> startIndices, DijkstraBitFlags flags);
     DijkstraSearchObject(const Graph& graph, std::vector<VertexInfo>& vertexInfo, vertIndex startIndex, vertIndex endIndex, DijkstraBitFlags flags);
     DijkstraSearchObject(const Graph& graph, std::vector<VertexInfo>& vertexInfo, std::vector<vertIndex> startIndices, vertIndex endIndex, DijkstraBitFlags flags);
+    DijkstraSearchObject(const CSRGraph& graph, std::vector<VertexInfo>& vertexInfo, vertIndex startIndex, DijkstraBitFlags flags);
+    DijkstraSearchObject(const CSRGraph& graph, std::vector<VertexInfo>& vertexInfo, std::vector<vertIndex> startIndices, DijkstraBitFlags flags);
+    DijkstraSearchObject(const CSRGraph& graph, std::vector<VertexInfo>& vertexInfo, vertIndex startIndex, vertIndex endIndex, DijkstraBitFlags flags);
+    DijkstraSearchObject(const CSRGraph& graph, std::vector<VertexInfo>& vertexInfo, std::vector<vertIndex> startIndices, vertIndex endIndex, DijkstraBitFlags flags);
     vertIndexList Search();
 
+protected:
+    template<typename GraphType, typename StateType> vertIndexList Search(const GraphType& graph, StateType& state);
+
 public:
-    const Graph& m_Graph;
+    // Only one of these is set, depending on which constructor was used.
+    const Graph* m_pGraph;
+    const CSRGraph* m_pCSRGraph;
     std::vector<VertexInfo>& m_VertexInfo;
     pointIndexList m_StartIndices;
     vertIndex m_EndIndex;
@@ -37,6 +49,14 @@ public:
 
     float m_MaxWeight;
 
+    // For DBF_AStar, the straight line distance to the end is multiplied by this to estimate the weight left.
+    // Negative uses the CSRGraph's minWeightPerDistance, or 0 for a Graph or if there's a weight callback since the graph's weights aren't used then.
+    float m_HeuristicScale;
+
+    // If set, closed flags, weights and parents are kept here instead of in m_VertexInfo, which skips clearing every vertex
+    //   before the search. Owners for DBF_ForceSameOwnership are still read from m_VertexInfo.
+    SearchWorkspace* m_pWorkspace;
+
     PostInitCallback m_pPostInitCallback;
     VertexSelectedFromOpenListCallback m_pVertexSelectedFromOpenListCallback;
     WeightCalculationCallback m_pWeightCalculationCallback;
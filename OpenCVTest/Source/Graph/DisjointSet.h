@@ -0,0 +1,53 @@
+#ifndef __DisjointSet_H__
+#define __DisjointSet_H__
+
+#include "Graph/GraphTypes.h"
+
+// Union-find over vertex indices, with union by size and path halving, so both calls are close to constant time.
+class DisjointSet
+{
+protected:
+    std::vector<vertIndex> m_Parents;
+    std::vector<vertIndex> m_Sizes;
+
+public:
+    DisjointSet(size_t numItems = 0) { Reset( numItems ); }
+
+    void Reset(size_t numItems)
+    {
+        m_Parents.resize( numItems );
+        m_Sizes.assign( numItems, 1 );
+        for( size_t i=0; i<numItems; i++ )
+        {
+            m_Parents[i] = i;
+        }
+    }
+
+    vertIndex Find(vertIndex item)
+    {
+        while( m_Parents[item] != item )
+        {
+            m_Parents[item] = m_Parents[m_Parents[item]];
+            item = m_Parents[item];
+        }
+        return item;
+    }
+
+    // Returns false if the two items were already in the same set.
+    bool Union(vertIndex item1, vertIndex item2)
+    {
+        vertIndex root1 = Find( item1 );
+        vertIndex root2 = Find( item2 );
+        if( root1 == root2 )
+            return false;
+
+        if( m_Sizes[root1] < m_Sizes[root2] )
+            std::swap( root1, root2 );
+
+        m_Parents[root2] = root1;
+        m_Sizes[root1] += m_Sizes[root2];
+        return true;
+    }
+};
+
+#endif //__DisjointSet_H__
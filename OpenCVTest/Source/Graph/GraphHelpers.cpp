@@ -1,8 +1,14 @@
 #include "OpenCVPCH.h"
 
+#include <atomic>
+
 #include "GraphTypes.h"
 #include "GraphHelpers.h"
 #include "DijkstraSearchObject.h"
+#include "DisjointSet.h"
+#include "PriorityQueue.h"
+#include "SearchWorkspace.h"
+#include "SpatialIndex.h"
 
 #pragma warning (push)
 #pragma warning (disable:4623)
@@ -35,6 +41,142 @@ void IndexGraph::Clear()
 //{
 //}
 
+void CSRGraph::Clear()
+{
+    points.clear();
+    offsets.clear();
+    neighbours.clear();
+    weights.clear();
+    minWeightPerDistance = 0;
+}
+
+void CSRGraph::Build(const pointList& points, const fullNeighbourList& neighbours, const fullEdgeList& weights)
+{
+    assert( points.size() == neighbours.size() );
+
+    size_t numVerts = points.size();
+
+    this->points = points;
+
+    // Prefix sum of the degrees.
+    offsets.resize( numVerts + 1 );
+    offsets[0] = 0;
+    for( size_t i=0; i<numVerts; i++ )
+    {
+        offsets[i+1] = offsets[i] + neighbours[i].size();
+    }
+
+    // Copy each vertex's neighbours into its row, sorted so rows come out the same no matter the hash set order.
+    this->neighbours.resize( offsets[numVerts] );
+    for( size_t i=0; i<numVerts; i++ )
+    {
+        vertIndex* row = this->neighbours.data() + offsets[i];
+        std::copy( neighbours[i].begin(), neighbours[i].end(), row );
+        std::sort( row, row + neighbours[i].size() );
+    }
+
+    SetWeights( weights );
+}
+
+void CSRGraph::Build(const Graph& graph)
+{
+    Build( graph.points, graph.neighbours, graph.weights );
+}
+
+void CSRGraph::SetWeights(const fullEdgeList& weights)
+{
+    this->weights.resize( neighbours.size() );
+
+    float minRatio = FLT_MAX;
+
+    for( size_t i=0; i<points.size(); i++ )
+    {
+        // Edges are only stored in the lower index's list, so look up both directions there.
+        for( size_t e=offsets[i]; e<offsets[i+1]; e++ )
+        {
+            vertIndex n = neighbours[e];
+            vertIndex lowerIndex = std::min( (vertIndex)i, n );
+            vertIndex higherIndex = std::max( (vertIndex)i, n );
+
+            float length = points[i].DistanceFrom( points[n] );
+            edgeWeight weight = length;
+
+            auto itLower = weights.find( lowerIndex );
+            if( itLower != weights.end() )
+            {
+                auto itHigher = itLower->second.find( higherIndex );
+                if( itHigher != itLower->second.end() )
+                    weight = itHigher->second;
+            }
+
+            this->weights[e] = weight;
+
+            if( length > 0 )
+            {
+                minRatio = std::min( minRatio, weight / length );
+            }
+        }
+    }
+
+    // Same fallback as GetMinimumWeightPerDistance, no usable edges or negative weights means no heuristic.
+    minWeightPerDistance = ( minRatio == FLT_MAX || minRatio < 0 ) ? 0 : minRatio;
+}
+
+void CSRGraph::ToGraph(Graph& graph) const
+{
+    graph.Clear();
+    graph.points = points;
+    graph.neighbours = ToNeighbourList();
+    graph.weights = ToEdgeList();
+}
+
+fullNeighbourList CSRGraph::ToNeighbourList() const
+{
+    fullNeighbourList list( points.size() );
+
+    for( size_t i=0; i<points.size(); i++ )
+    {
+        list[i].reserve( offsets[i+1] - offsets[i] );
+        list[i].insert( neighbours.begin() + offsets[i], neighbours.begin() + offsets[i+1] );
+    }
+
+    return list;
+}
+
+fullEdgeList CSRGraph::ToEdgeList() const
+{
+    fullEdgeList edgeList;
+
+    for( size_t i=0; i<points.size(); i++ )
+    {
+        for( size_t e=offsets[i]; e<offsets[i+1]; e++ )
+        {
+            // Only add the neighbour to the list if the source index is less than the dest.
+            if( i < neighbours[e] )
+            {
+                edgeList[i][neighbours[e]] = weights[e];
+            }
+        }
+    }
+
+    return edgeList;
+}
+
+bool CSRGraph::PointHasNeighbour(vertIndex point, vertIndex neighbourToTestFor) const
+{
+    return std::binary_search( neighbours.begin() + offsets[point], neighbours.begin() + offsets[point+1], neighbourToTestFor );
+}
+
+edgeWeight CSRGraph::GetWeight(vertIndex v1, vertIndex v2) const
+{
+    auto rowStart = neighbours.begin() + offsets[v1];
+    auto rowEnd = neighbours.begin() + offsets[v1+1];
+    auto it = std::lower_bound( rowStart, rowEnd, v2 );
+    assert( it != rowEnd && *it == v2 );
+
+    return weights[it - neighbours.begin()];
+}
+
 float GetDifferenceBetweenAngles(float angle1, float angle2)
 {
     float angleDiff = fabs( angle1 - angle2 );
@@ -205,18 +347,15 @@ fullNeighbourList CreateNeighbourList(const pointList& points, float maxDistance
     return neighbours;
 }
 
-fullEdgeList CreateEdgeListWithWeights(const Graph& graph, bool randomWeights, int randomSeed, float fixedWeight)
+template<typename GraphType> static fullEdgeList CreateEdgeListWithWeightsImpl(const GraphType& graph, bool randomWeights, int randomSeed, float fixedWeight)
 {
     fullEdgeList edgeList;
 
-    if( randomWeights )
-    {
-        srand( randomSeed );
-    }
+    RandomStream stream( (uint32)randomSeed );
 
-    for( size_t i=0; i<graph.neighbours.size(); i++ )
+    for( size_t i=0; i<graph.GetVertexCount(); i++ )
     {
-        const neighbourList& currentNeighbours = graph.neighbours[i];
+        const auto& currentNeighbours = graph.GetNeighbours( i );
 
         for( const vertIndex nIndex : currentNeighbours )
         {
@@ -230,7 +369,8 @@ fullEdgeList CreateEdgeListWithWeights(const Graph& graph, bool randomWeights, i
                 }
                 else if( randomWeights )
                 {
-                    weight = (float)rand() / RAND_MAX;
+                    // Keyed by the edge, so the weight doesn't depend on the order edges are visited.
+                    weight = stream.FloatAt( ((uint64)i << 32) | nIndex, 0, 0.0f, 1.0f );
                 }
                 else
                 {
@@ -247,7 +387,17 @@ fullEdgeList CreateEdgeListWithWeights(const Graph& graph, bool randomWeights, i
     return edgeList;
 }
 
-fullEdgeList CreateEdgeListWithWeightsUsingVectorField(const Graph& graph, const std::vector<float>& rotations)
+fullEdgeList CreateEdgeListWithWeights(const Graph& graph, bool randomWeights, int randomSeed, float fixedWeight)
+{
+    return CreateEdgeListWithWeightsImpl( graph, randomWeights, randomSeed, fixedWeight );
+}
+
+fullEdgeList CreateEdgeListWithWeights(const CSRGraph& graph, bool randomWeights, int randomSeed, float fixedWeight)
+{
+    return CreateEdgeListWithWeightsImpl( graph, randomWeights, randomSeed, fixedWeight );
+}
+
+template<typename GraphType> static fullEdgeList CreateEdgeListWithWeightsUsingVectorFieldImpl(const GraphType& graph, const std::vector<float>& rotations)
 {
     assert( false ); // Not really useful since it's coded for bidirectional vectors.
     fullEdgeList edgeList;
@@ -255,9 +405,9 @@ fullEdgeList CreateEdgeListWithWeightsUsingVectorField(const Graph& graph, const
     if( rotations.size() < graph.points.size() )
         return edgeList;
 
-    for( size_t i=0; i<graph.neighbours.size(); i++ )
+    for( size_t i=0; i<graph.GetVertexCount(); i++ )
     {
-        const neighbourList& currentNeighbours = graph.neighbours[i];
+        const auto& currentNeighbours = graph.GetNeighbours( i );
 
         for( const vertIndex nIndex : currentNeighbours )
         {
@@ -278,7 +428,17 @@ fullEdgeList CreateEdgeListWithWeightsUsingVectorField(const Graph& graph, const
     return edgeList;
 }
 
-fullEdgeList CreateEdgeListWithWeightsFromSourceImage(const Graph& graph, const cv::Mat& weightImage)
+fullEdgeList CreateEdgeListWithWeightsUsingVectorField(const Graph& graph, const std::vector<float>& rotations)
+{
+    return CreateEdgeListWithWeightsUsingVectorFieldImpl( graph, rotations );
+}
+
+fullEdgeList CreateEdgeListWithWeightsUsingVectorField(const CSRGraph& graph, const std::vector<float>& rotations)
+{
+    return CreateEdgeListWithWeightsUsingVectorFieldImpl( graph, rotations );
+}
+
+template<typename GraphType> static fullEdgeList CreateEdgeListWithWeightsFromSourceImageImpl(const GraphType& graph, const cv::Mat& weightImage, const PointDomain& domain)
 {
     fullEdgeList edgeList;
 
@@ -287,9 +447,9 @@ fullEdgeList CreateEdgeListWithWeightsFromSourceImage(const Graph& graph, const
     uint32 imageWidth = weightImage.cols;
     uint32 imageHeight = weightImage.rows;
 
-    for( size_t i=0; i<graph.neighbours.size(); i++ )
+    for( size_t i=0; i<graph.GetVertexCount(); i++ )
     {
-        const neighbourList& currentNeighbours = graph.neighbours[i];
+        const auto& currentNeighbours = graph.GetNeighbours( i );
 
         for( const vertIndex nIndex : currentNeighbours )
         {
@@ -299,14 +459,14 @@ fullEdgeList CreateEdgeListWithWeightsFromSourceImage(const Graph& graph, const
                 float blackWeight = 0.1f;
                 float whiteWeight = 1.0f;
 
-                float cPercX = graph.points[i].x / 100.0f;
-                float cPercY = graph.points[i].y / 100.0f;
-                ivec2 cPos = ivec2( (int)(cPercX * imageWidth), (int)(cPercY * imageHeight) );
+                vec2 cPerc = domain.ToNormalized( graph.points[i] );
+                ivec2 cPos = ivec2( (int)(cPerc.x * imageWidth), (int)(cPerc.y * imageHeight) );
+                cPos.Set( std::min( std::max( cPos.x, 0 ), (int)imageWidth-1 ), std::min( std::max( cPos.y, 0 ), (int)imageHeight-1 ) );
                 float cValue = imageValues[cPos.y*imageStride + cPos.x][0] * (whiteWeight - blackWeight) + blackWeight;
 
-                float nPercX = graph.points[nIndex].x / 100.0f;
-                float nPercY = graph.points[nIndex].y / 100.0f;
-                ivec2 nPos = ivec2( (int)(nPercX * imageWidth), (int)(nPercY * imageHeight) );
+                vec2 nPerc = domain.ToNormalized( graph.points[nIndex] );
+                ivec2 nPos = ivec2( (int)(nPerc.x * imageWidth), (int)(nPerc.y * imageHeight) );
+                nPos.Set( std::min( std::max( nPos.x, 0 ), (int)imageWidth-1 ), std::min( std::max( nPos.y, 0 ), (int)imageHeight-1 ) );
                 float nValue = imageValues[nPos.y*imageStride + nPos.x][0] * (whiteWeight - blackWeight) + blackWeight;
 
                 float weight = (cValue + nValue) / 2;
@@ -321,7 +481,17 @@ fullEdgeList CreateEdgeListWithWeightsFromSourceImage(const Graph& graph, const
     return edgeList;
 }
 
-graphPath FindShortestPath(const Graph& graph, vertIndex startIndex, vertIndex endIndex)
+fullEdgeList CreateEdgeListWithWeightsFromSourceImage(const Graph& graph, const cv::Mat& weightImage, const PointDomain& domain)
+{
+    return CreateEdgeListWithWeightsFromSourceImageImpl( graph, weightImage, domain );
+}
+
+fullEdgeList CreateEdgeListWithWeightsFromSourceImage(const CSRGraph& graph, const cv::Mat& weightImage, const PointDomain& domain)
+{
+    return CreateEdgeListWithWeightsFromSourceImageImpl( graph, weightImage, domain );
+}
+
+template<typename GraphType> static graphPath FindShortestPathImpl(const GraphType& graph, vertIndex startIndex, vertIndex endIndex)
 {
     graphPath path;
 
@@ -332,7 +502,7 @@ graphPath FindShortestPath(const Graph& graph, vertIndex startIndex, vertIndex e
     while( currentIndex != endIndex )
     {
         vec2 currentPos = graph.points[currentIndex];
-        const neighbourList& currentNeighbours = graph.neighbours[currentIndex];
+        const auto& currentNeighbours = graph.GetNeighbours( currentIndex );
 
         edgeWeight lowestWeight = FLT_MAX;
         vertIndex closestIndex = 0;
@@ -344,9 +514,7 @@ graphPath FindShortestPath(const Graph& graph, vertIndex startIndex, vertIndex e
                 break;
             }
 
-            vertIndex lowerIndex = currentIndex < nIndex ? currentIndex : nIndex;
-            vertIndex higherIndex = currentIndex > nIndex ? currentIndex : nIndex;
-            edgeWeight weight = graph.weights.at(lowerIndex).at(higherIndex);
+            edgeWeight weight = graph.GetWeight( currentIndex, nIndex );
 
             if( weight < lowestWeight )
             {
@@ -362,6 +530,16 @@ graphPath FindShortestPath(const Graph& graph, vertIndex startIndex, vertIndex e
     return path;
 }
 
+graphPath FindShortestPath(const Graph& graph, vertIndex startIndex, vertIndex endIndex)
+{
+    return FindShortestPathImpl( graph, startIndex, endIndex );
+}
+
+graphPath FindShortestPath(const CSRGraph& graph, vertIndex startIndex, vertIndex endIndex)
+{
+    return FindShortestPathImpl( graph, startIndex, endIndex );
+}
+
 graphPath FindShortestPath_Dijkstra(const Graph& graph, vertIndex startIndex, vec2 endPosition)
 {
     std::pair<vertIndex, float> pointInfo = FindNearestPoint( graph.points, endPosition );
@@ -371,105 +549,294 @@ graphPath FindShortestPath_Dijkstra(const Graph& graph, vertIndex startIndex, ve
     return FindShortestPath_Dijkstra( graph, startIndex, endIndex );
 }
 
-graphPath FindShortestPath_Dijkstra(const Graph& graph, vertIndex startIndex, vertIndex endIndex)
+graphPath FindShortestPath_Dijkstra(const CSRGraph& graph, vertIndex startIndex, vec2 endPosition)
 {
-    assert( graph.points.size() == graph.neighbours.size() );
+    std::pair<vertIndex, float> pointInfo = FindNearestPoint( graph.points, endPosition );
+    vertIndex endIndex = pointInfo.first;
+    //float pointDist = pointInfo.second;
+
+    return FindShortestPath_Dijkstra( graph, startIndex, endIndex );
+}
 
+template<typename GraphType> static graphPath FindShortestPath_DijkstraImpl(const GraphType& graph, vertIndex startIndex, vertIndex endIndex, SearchWorkspace& workspace)
+{
     if( startIndex >= graph.points.size() || endIndex >= graph.points.size() )
     {
         return graphPath();
     }
 
-    std::vector<VertexInfo> vertexInfo;
-    for( size_t i=0; i<graph.points.size(); i++ )
-    {
-        vertexInfo.push_back( VertexInfo(i) );
-    }
+    workspace.BeginSearch( graph.points.size() );
 
-    // Open list, sorted from worst to best.
-    pointIndexList openList;
-    openList.push_back( startIndex );
-    vertexInfo[startIndex].lowestWeight = 0;
+    // Open list, a heap keyed on the lowest known weight for each vertex.
+    IndexedPriorityQueue& openList = workspace.GetOpenList();
+    openList.PushOrDecrease( startIndex, 0 );
+    workspace.SetDistance( startIndex, 0 );
 
-    while( openList.size() > 0 )
+    while( openList.IsEmpty() == false )
     {
-        // Grab the last element of the open list, which is the lowest weight vertex.
-        vertIndex currentIndex = openList[openList.size()-1];
-        openList.pop_back();
-        vertexInfo[currentIndex].closed = true;
+        // Grab the lowest weight vertex.
+        vertIndex currentIndex = openList.PopMin();
+        workspace.SetClosed( currentIndex );
 
         if( currentIndex == endIndex )
             break;
 
         // Loop through neighbours.
-        for( const vertIndex nIndex : graph.neighbours[currentIndex] )
+        graph.ForEachWeightedNeighbour( currentIndex, [&](vertIndex nIndex, edgeWeight weight)
         {
             // If the neighbour is closed, skip over it.
-            if( vertexInfo[nIndex].closed == false )
+            if( workspace.IsClosed( nIndex ) == false )
             {
-                vertIndex lowerIndex = currentIndex < nIndex ? currentIndex : nIndex;
-                vertIndex higherIndex = currentIndex > nIndex ? currentIndex : nIndex;
-                edgeWeight weight = graph.weights.at(lowerIndex).at(higherIndex);
-
-                edgeWeight totalWeight = vertexInfo[currentIndex].lowestWeight + weight;
+                edgeWeight totalWeight = workspace.GetDistance( currentIndex ) + weight;
 
                 // If this is a shorter way to reach this vertex, update it with a new parent/cost.
-                if( totalWeight < vertexInfo[nIndex].lowestWeight )
+                if( totalWeight < workspace.GetDistance( nIndex ) )
                 {
-                    vertexInfo[nIndex].lowestWeight = totalWeight;
+                    workspace.SetDistance( nIndex, totalWeight );
+                    workspace.SetParent( nIndex, currentIndex );
 
-                    // If we already have a parent, then we have an old cost which was higher.
-                    // Remove from open list and re-add it sorted in new position.
-                    if( vertexInfo[nIndex].parentIndex != -1 && vertexInfo[nIndex].closed == false )
-                    {
-                        auto it = std::find( openList.begin(), openList.end(), nIndex );
-                        if( it != openList.end() )
-                        {
-                            openList.erase( it );
-                        }
-                    }
+                    // Adds the vertex or moves it up the heap if it was already open with a higher cost.
+                    openList.PushOrDecrease( nIndex, totalWeight );
+                }
+            }
+        } );
+    }
 
-                    // Insert into open list sorted in descending order.
-                    {
-                        bool inserted = false;
-                        for( size_t i=0; i<openList.size(); i++ )
-                        {
-                            if( totalWeight > vertexInfo[openList[i]].lowestWeight )
-                            {
-                                inserted = true;
-                                openList.insert( openList.begin() + i, nIndex );
-                                break;
-                            }
-                        }
+    return workspace.BuildPath( endIndex );
+}
 
-                        // If the list was empty or we didn't find a shorter path,
-                        // insert the element at the end of the list.
-                        if( inserted == false )
-                        {
-                            openList.push_back( nIndex );
-                        }
-                    }
+graphPath FindShortestPath_Dijkstra(const Graph& graph, vertIndex startIndex, vertIndex endIndex)
+{
+    return FindShortestPath_DijkstraImpl( graph, startIndex, endIndex, SearchWorkspace::GetThreadLocal() );
+}
 
-                    // Set the new parent.
-                    vertexInfo[nIndex].parentIndex = currentIndex;
-                }
+graphPath FindShortestPath_Dijkstra(const CSRGraph& graph, vertIndex startIndex, vertIndex endIndex)
+{
+    return FindShortestPath_DijkstraImpl( graph, startIndex, endIndex, SearchWorkspace::GetThreadLocal() );
+}
+
+graphPath FindShortestPath_Dijkstra(const Graph& graph, vertIndex startIndex, vertIndex endIndex, SearchWorkspace& workspace)
+{
+    return FindShortestPath_DijkstraImpl( graph, startIndex, endIndex, workspace );
+}
+
+graphPath FindShortestPath_Dijkstra(const CSRGraph& graph, vertIndex startIndex, vertIndex endIndex, SearchWorkspace& workspace)
+{
+    return FindShortestPath_DijkstraImpl( graph, startIndex, endIndex, workspace );
+}
+
+float GetMinimumWeightPerDistance(const Graph& graph)
+{
+    float minRatio = FLT_MAX;
+
+    for( vertIndex v=0; v<graph.GetVertexCount(); v++ )
+    {
+        graph.ForEachWeightedNeighbour( v, [&](vertIndex nIndex, edgeWeight weight)
+        {
+            // Each edge is seen from both ends, only check it once.
+            if( nIndex < v )
+                return;
+
+            float length = graph.points[v].DistanceFrom( graph.points[nIndex] );
+            if( length > 0 )
+            {
+                minRatio = std::min( minRatio, weight / length );
             }
-        }
+        } );
     }
 
-    graphPath path;
+    // No usable edges, or negative weights, fall back to no heuristic at all.
+    if( minRatio == FLT_MAX || minRatio < 0 )
+        return 0;
+
+    return minRatio;
+}
+
+float GetMinimumWeightPerDistance(const CSRGraph& graph)
+{
+    return graph.minWeightPerDistance;
+}
+
+template<typename GraphType> static graphPath FindShortestPath_AStarImpl(const GraphType& graph, vertIndex startIndex, vertIndex endIndex, float heuristicScale)
+{
+    if( startIndex >= graph.points.size() || endIndex >= graph.points.size() )
+    {
+        return graphPath();
+    }
+
+    vec2 endPos = graph.points[endIndex];
+
+    SearchWorkspace& workspace = SearchWorkspace::GetThreadLocal();
+    workspace.BeginSearch( graph.points.size() );
+
+    // Open list, keyed on the weight so far plus the estimate of what's left.
+    IndexedPriorityQueue& openList = workspace.GetOpenList();
+    openList.PushOrDecrease( startIndex, heuristicScale * graph.points[startIndex].DistanceFrom( endPos ) );
+    workspace.SetDistance( startIndex, 0 );
+
+    while( openList.IsEmpty() == false )
+    {
+        vertIndex currentIndex = openList.PopMin();
+        workspace.SetClosed( currentIndex );
+
+        if( currentIndex == endIndex )
+            break;
+
+        graph.ForEachWeightedNeighbour( currentIndex, [&](vertIndex nIndex, edgeWeight weight)
+        {
+            if( workspace.IsClosed( nIndex ) )
+                return;
+
+            edgeWeight totalWeight = workspace.GetDistance( currentIndex ) + weight;
+
+            if( totalWeight < workspace.GetDistance( nIndex ) )
+            {
+                workspace.SetDistance( nIndex, totalWeight );
+                workspace.SetParent( nIndex, currentIndex );
 
-    vertIndex i = endIndex;
-    while( i != -1 )
+                openList.PushOrDecrease( nIndex, totalWeight + heuristicScale * graph.points[nIndex].DistanceFrom( endPos ) );
+            }
+        } );
+    }
+
+    return workspace.BuildPath( endIndex );
+}
+
+template<typename GraphType> static graphPath FindShortestPath_BidirectionalAStarImpl(const GraphType& graph, vertIndex startIndex, vertIndex endIndex, float heuristicScale)
+{
+    if( startIndex >= graph.points.size() || endIndex >= graph.points.size() )
+    {
+        return graphPath();
+    }
+
+    if( startIndex == endIndex )
+    {
+        return graphPath( 1, endIndex );
+    }
+
+    vec2 startPos = graph.points[startIndex];
+    vec2 endPos = graph.points[endIndex];
+
+    // Both searches use the average of the two straight line estimates, the forward search adds it and the backward one subtracts it.
+    // That keeps both searches consistent with each other, so they can stop as soon as the two open lists can't beat the best meeting point.
+    auto potential = [&](vertIndex v)
+    {
+        return heuristicScale * 0.5f * ( graph.points[v].DistanceFrom( endPos ) - graph.points[v].DistanceFrom( startPos ) );
+    };
+
+    // Side 0 searches forward from the start, side 1 backward from the end.
+    SearchWorkspace* workspaces[2] = { &SearchWorkspace::GetThreadLocal( 0 ), &SearchWorkspace::GetThreadLocal( 1 ) };
+    IndexedPriorityQueue* openList[2];
+    for( int side=0; side<2; side++ )
+    {
+        workspaces[side]->BeginSearch( graph.points.size() );
+        openList[side] = &workspaces[side]->GetOpenList();
+    }
+
+    workspaces[0]->SetDistance( startIndex, 0 );
+    workspaces[1]->SetDistance( endIndex, 0 );
+    openList[0]->PushOrDecrease( startIndex, potential( startIndex ) );
+    openList[1]->PushOrDecrease( endIndex, -potential( endIndex ) );
+
+    edgeWeight bestPathWeight = FLT_MAX;
+    vertIndex meetingIndex = -1;
+
+    while( openList[0]->IsEmpty() == false && openList[1]->IsEmpty() == false )
+    {
+        if( openList[0]->GetMinKey() + openList[1]->GetMinKey() >= bestPathWeight )
+            break;
+
+        // Grow whichever side has less open, that keeps the two searches roughly balanced.
+        int side = openList[0]->Size() <= openList[1]->Size() ? 0 : 1;
+        float sign = side == 0 ? 1.0f : -1.0f;
+        SearchWorkspace& info = *workspaces[side];
+        const SearchWorkspace& otherInfo = *workspaces[1-side];
+
+        vertIndex currentIndex = openList[side]->PopMin();
+        info.SetClosed( currentIndex );
+
+        graph.ForEachWeightedNeighbour( currentIndex, [&](vertIndex nIndex, edgeWeight weight)
+        {
+            if( info.IsClosed( nIndex ) )
+                return;
+
+            edgeWeight totalWeight = info.GetDistance( currentIndex ) + weight;
+
+            if( totalWeight < info.GetDistance( nIndex ) )
+            {
+                info.SetDistance( nIndex, totalWeight );
+                info.SetParent( nIndex, currentIndex );
+
+                openList[side]->PushOrDecrease( nIndex, totalWeight + sign * potential( nIndex ) );
+
+                // If the other side has reached this vertex, it joins a full path.
+                edgeWeight otherWeight = otherInfo.GetDistance( nIndex );
+                if( otherWeight != FLT_MAX && totalWeight + otherWeight < bestPathWeight )
+                {
+                    bestPathWeight = totalWeight + otherWeight;
+                    meetingIndex = nIndex;
+                }
+            }
+        } );
+    }
+
+    // Same as the one directional searches, an unreachable end gives a path with only the end in it.
+    if( meetingIndex == -1 )
     {
-        path.push_back( i );
-        i = vertexInfo[i].parentIndex;
+        return graphPath( 1, endIndex );
     }
 
+    // End to meeting point, then meeting point back to the start.
+    graphPath path = workspaces[1]->BuildPath( meetingIndex );
+    std::reverse( path.begin(), path.end() );
+    path.pop_back();
+
+    graphPath startHalf = workspaces[0]->BuildPath( meetingIndex );
+    path.insert( path.end(), startHalf.begin(), startHalf.end() );
+
     return path;
 }
 
-linearWeightedEdgeList GenerateMinimumSpanningTree(const Graph& graph)
+graphPath FindShortestPath_AStar(const Graph& graph, vertIndex startIndex, vec2 endPosition, bool bidirectional, float heuristicScale)
+{
+    std::pair<vertIndex, float> pointInfo = FindNearestPoint( graph.points, endPosition );
+
+    return FindShortestPath_AStar( graph, startIndex, pointInfo.first, bidirectional, heuristicScale );
+}
+
+graphPath FindShortestPath_AStar(const CSRGraph& graph, vertIndex startIndex, vec2 endPosition, bool bidirectional, float heuristicScale)
+{
+    std::pair<vertIndex, float> pointInfo = FindNearestPoint( graph.points, endPosition );
+
+    return FindShortestPath_AStar( graph, startIndex, pointInfo.first, bidirectional, heuristicScale );
+}
+
+graphPath FindShortestPath_AStar(const Graph& graph, vertIndex startIndex, vertIndex endIndex, bool bidirectional, float heuristicScale)
+{
+    // Measuring the scale here would cost a pass over every edge per query, so Graph callers have to pass one in.
+    assert( heuristicScale >= 0 );
+    heuristicScale = std::max( heuristicScale, 0.0f );
+
+    if( bidirectional )
+        return FindShortestPath_BidirectionalAStarImpl( graph, startIndex, endIndex, heuristicScale );
+
+    return FindShortestPath_AStarImpl( graph, startIndex, endIndex, heuristicScale );
+}
+
+graphPath FindShortestPath_AStar(const CSRGraph& graph, vertIndex startIndex, vertIndex endIndex, bool bidirectional, float heuristicScale)
+{
+    if( heuristicScale < 0 )
+    {
+        heuristicScale = graph.minWeightPerDistance;
+    }
+
+    if( bidirectional )
+        return FindShortestPath_BidirectionalAStarImpl( graph, startIndex, endIndex, heuristicScale );
+
+    return FindShortestPath_AStarImpl( graph, startIndex, endIndex, heuristicScale );
+}
+
+template<typename GraphType> static linearWeightedEdgeList GenerateMinimumSpanningTree_PrimImpl(const GraphType& graph)
 {
     // Storage for generated list of edges in MST.
     linearWeightedEdgeList mstEdges;
@@ -492,20 +859,16 @@ linearWeightedEdgeList GenerateMinimumSpanningTree(const Graph& graph)
 
         // Add all connected edges into the active list.
         // Sort by weight. Smallest on top of heap by multiplying by -1.
-        for( const vertIndex n : graph.neighbours[currentVertex] )
+        graph.ForEachWeightedNeighbour( currentVertex, [&](vertIndex n, edgeWeight weight)
         {
-            size_t lowerIndex = currentVertex < n ? currentVertex : n;
-            size_t higherIndex = currentVertex > n ? currentVertex : n;
-            edgeWeight weight = graph.weights.at(lowerIndex).at(higherIndex);
-
             activeEdges.push( { weight*-1, currentVertex, n } );
-        }
+        } );
 
         // Grab the lowest weighted edge that connects to a vertex not already in the MST.
         nextVertex = -1;
         while( activeEdges.empty() == false )
         {
-            auto& info = activeEdges.top();
+            weightedEdge info = activeEdges.top();
             vertIndex v1 = std::get<EdgeIndex1>( info );
             vertIndex v2 = std::get<EdgeIndex2>( info );
             activeEdges.pop();
@@ -513,7 +876,7 @@ linearWeightedEdgeList GenerateMinimumSpanningTree(const Graph& graph)
             if( parents[v2] == -1 )
             {
                 nextVertex = v2;
-                mstEdges.push_back( { 1.0f, v1, v2 } ); // TODO: fix the 1.0f.
+                mstEdges.push_back( { std::get<EdgeWeight>( info ) * -1, v1, v2 } );
                 break;
             }
         }
@@ -522,6 +885,162 @@ linearWeightedEdgeList GenerateMinimumSpanningTree(const Graph& graph)
     return mstEdges;
 }
 
+// Edges are compared by weight, then by their vertex indices, so there's only ever one minimum spanning forest
+//   and Kruskal and Boruvka always agree.
+static bool IsLighterEdge(const weightedEdge& edge1, const weightedEdge& edge2)
+{
+    return edge1 < edge2;
+}
+
+// Each edge once, with the lower vertex index first.
+template<typename GraphType> static linearWeightedEdgeList CreateSortedEdgeArray(const GraphType& graph)
+{
+    linearWeightedEdgeList edges;
+
+    for( vertIndex v=0; v<graph.GetVertexCount(); v++ )
+    {
+        graph.ForEachWeightedNeighbour( v, [&](vertIndex n, edgeWeight weight)
+        {
+            if( v < n )
+            {
+                edges.push_back( { weight, v, n } );
+            }
+        } );
+    }
+
+    std::sort( edges.begin(), edges.end(), IsLighterEdge );
+
+    return edges;
+}
+
+template<typename GraphType> static linearWeightedEdgeList GenerateMinimumSpanningTree_KruskalImpl(const GraphType& graph)
+{
+    linearWeightedEdgeList mstEdges;
+
+    size_t numVerts = graph.GetVertexCount();
+    if( numVerts == 0 )
+        return mstEdges;
+
+    linearWeightedEdgeList edges = CreateSortedEdgeArray( graph );
+
+    // Take the lightest edges that join two different trees, until everything connected is one tree.
+    DisjointSet trees( numVerts );
+    for( const weightedEdge& edge : edges )
+    {
+        if( trees.Union( std::get<EdgeIndex1>( edge ), std::get<EdgeIndex2>( edge ) ) )
+        {
+            mstEdges.push_back( edge );
+            if( mstEdges.size() == numVerts-1 )
+                break;
+        }
+    }
+
+    return mstEdges;
+}
+
+template<typename GraphType> static linearWeightedEdgeList GenerateMinimumSpanningTree_BoruvkaImpl(const GraphType& graph)
+{
+    linearWeightedEdgeList mstEdges;
+
+    size_t numVerts = graph.GetVertexCount();
+    if( numVerts == 0 )
+        return mstEdges;
+
+    const weightedEdge noEdge( FLT_MAX, (vertIndex)-1, (vertIndex)-1 );
+
+    DisjointSet trees( numVerts );
+    std::vector<vertIndex> treeOfVertex( numVerts );
+    std::vector<weightedEdge> cheapestFromVertex( numVerts );
+    std::vector<weightedEdge> cheapestFromTree( numVerts );
+
+    // Each round at least halves the number of trees that still have edges leaving them.
+    while( true )
+    {
+        for( vertIndex v=0; v<numVerts; v++ )
+        {
+            treeOfVertex[v] = trees.Find( v );
+        }
+
+        // Every vertex finds its cheapest edge to another tree, in parallel since each only writes its own slot.
+        cv::parallel_for_( cv::Range( 0, (int)numVerts ), [&](const cv::Range& range)
+        {
+            for( int i=range.start; i<range.end; i++ )
+            {
+                vertIndex v = i;
+                weightedEdge cheapest = noEdge;
+
+                graph.ForEachWeightedNeighbour( v, [&](vertIndex n, edgeWeight weight)
+                {
+                    if( treeOfVertex[n] == treeOfVertex[v] )
+                        return;
+
+                    weightedEdge edge( weight, std::min( v, n ), std::max( v, n ) );
+                    if( IsLighterEdge( edge, cheapest ) )
+                    {
+                        cheapest = edge;
+                    }
+                } );
+
+                cheapestFromVertex[v] = cheapest;
+            }
+        } );
+
+        // Then the cheapest edge out of each tree.
+        std::fill( cheapestFromTree.begin(), cheapestFromTree.end(), noEdge );
+        for( vertIndex v=0; v<numVerts; v++ )
+        {
+            weightedEdge& treeCheapest = cheapestFromTree[treeOfVertex[v]];
+            if( IsLighterEdge( cheapestFromVertex[v], treeCheapest ) )
+            {
+                treeCheapest = cheapestFromVertex[v];
+            }
+        }
+
+        // Join them. Two trees can pick the same edge, Union skips it the second time.
+        bool joinedAny = false;
+        for( vertIndex t=0; t<numVerts; t++ )
+        {
+            const weightedEdge& edge = cheapestFromTree[t];
+            if( std::get<EdgeIndex1>( edge ) == -1 )
+                continue;
+
+            if( trees.Union( std::get<EdgeIndex1>( edge ), std::get<EdgeIndex2>( edge ) ) )
+            {
+                mstEdges.push_back( edge );
+                joinedAny = true;
+            }
+        }
+
+        if( joinedAny == false )
+            break;
+    }
+
+    std::sort( mstEdges.begin(), mstEdges.end(), IsLighterEdge );
+
+    return mstEdges;
+}
+
+template<typename GraphType> static linearWeightedEdgeList GenerateMinimumSpanningTreeImpl(const GraphType& graph, MSTAlgorithm algorithm)
+{
+    switch( algorithm )
+    {
+    case MSTAlgorithm::Prim:        return GenerateMinimumSpanningTree_PrimImpl( graph );
+    case MSTAlgorithm::Boruvka:     return GenerateMinimumSpanningTree_BoruvkaImpl( graph );
+    case MSTAlgorithm::Kruskal:
+    default:                        return GenerateMinimumSpanningTree_KruskalImpl( graph );
+    }
+}
+
+linearWeightedEdgeList GenerateMinimumSpanningTree(const Graph& graph, MSTAlgorithm algorithm)
+{
+    return GenerateMinimumSpanningTreeImpl( graph, algorithm );
+}
+
+linearWeightedEdgeList GenerateMinimumSpanningTree(const CSRGraph& graph, MSTAlgorithm algorithm)
+{
+    return GenerateMinimumSpanningTreeImpl( graph, algorithm );
+}
+
 float DistanceFromLineSegment(vec2 start, vec2 end, vec2 point)
 {
     float dist;
@@ -570,14 +1089,14 @@ std::pair<int, float> FindNearestEdge(const pointList& points, const linearWeigh
     return { closestEdgeIndex, closestDist };
 }
 
-std::pair<vertIndex, float> FindNearestPoint(pointList pointList, vec2 point)
+std::pair<vertIndex, float> FindNearestPoint(const pointList& points, vec2 point)
 {
     vertIndex closestPointIndex = -1;
     float closestDist = FLT_MAX;
 
-    for( size_t i=0; i<pointList.size(); i++ )
+    for( size_t i=0; i<points.size(); i++ )
     {
-        float dist = pointList[i].DistanceFrom( point );
+        float dist = points[i].DistanceFrom( point );
         if( dist < closestDist )
         {
             closestDist = dist;
@@ -588,88 +1107,371 @@ std::pair<vertIndex, float> FindNearestPoint(pointList pointList, vec2 point)
     return { closestPointIndex, closestDist };
 }
 
-void SplitGraph_BFSFloodFillOwnership(treeIndex owner, vertIndex startIndex, std::vector<VertexInfo>& vertexInfo, const fullNeighbourList& neighbours, const fullEdgeList& edgeList, const linearWeightedEdgeList& activeEdges)
+// getWeight(v1, v2) returns the weight of an edge, so both the map based edge lists and CSRGraph weights can be used.
+template<typename WeightFunc> static void SplitGraph_BFSFloodFillOwnershipImpl(treeIndex owner, vertIndex startIndex, std::vector<VertexInfo>& vertexInfo, const fullNeighbourList& neighbours, WeightFunc getWeight)
 {
-    // Open list, sorted from worst to best.
-    pointIndexList openList;
-    openList.push_back( startIndex );
-    vertexInfo[startIndex].lowestWeight = 0;
-    vertexInfo[startIndex].owner = owner;
-
     for( size_t i=0; i<vertexInfo.size(); i++ )
     {
         vertexInfo[i].closed = false;
     }
 
-    while( openList.size() > 0 )
+    // Open list, a heap keyed on the lowest known weight for each vertex.
+    IndexedPriorityQueue openList;
+    openList.Reset( vertexInfo.size() );
+    openList.PushOrDecrease( startIndex, 0 );
+    vertexInfo[startIndex].lowestWeight = 0;
+    vertexInfo[startIndex].owner = owner;
+
+    while( openList.IsEmpty() == false )
     {
-        // Grab the last element of the open list, which is the lowest weight vertex.
-        vertIndex currentIndex = openList[openList.size()-1];
-        openList.pop_back();
+        // Grab the lowest weight vertex.
+        vertIndex currentIndex = openList.PopMin();
         vertexInfo[currentIndex].closed = true;
 
-        //if( currentIndex == endIndex )
-        //    break;
-
         // Loop through neighbours.
         for( const vertIndex nIndex : neighbours[currentIndex] )
         {
             // If the neighbour is closed, skip over it.
             if( vertexInfo[nIndex].closed == false )
             {
-                vertIndex lowerIndex = currentIndex < nIndex ? currentIndex : nIndex;
-                vertIndex higherIndex = currentIndex > nIndex ? currentIndex : nIndex;
-                edgeWeight weight = edgeList.at(lowerIndex).at(higherIndex);
+                edgeWeight weight = getWeight( currentIndex, nIndex );
 
                 edgeWeight totalWeight = vertexInfo[currentIndex].lowestWeight + weight;
 
                 // If this is a shorter way to reach this vertex, update it with a new parent/cost.
+                // Vertices already claimed by an earlier flood at a lower cost are left alone.
                 if( totalWeight < vertexInfo[nIndex].lowestWeight )
                 {
                     vertexInfo[nIndex].lowestWeight = totalWeight;
                     vertexInfo[nIndex].owner = owner;
+                    vertexInfo[nIndex].parentIndex = currentIndex;
 
-                    // If we already have a parent, then we have an old cost which was higher.
-                    // Remove from open list and re-add it sorted in new position.
-                    if( vertexInfo[nIndex].parentIndex != -1 && vertexInfo[nIndex].closed == false )
-                    {
-                        auto it = std::find( openList.begin(), openList.end(), nIndex );
-                        if( it != openList.end() )
-                        {
-                            openList.erase( it );
-                        }
-                    }
+                    openList.PushOrDecrease( nIndex, totalWeight );
+                }
+            }
+        }
+    }
+}
+
+// Seeds every root into one open list, so a single search leaves each vertex owned by its closest root.
+// Owners are the root's position in roots plus 1, matching one SplitGraph_BFSFloodFillOwnership flood per root,
+//   and ties go to the earlier root like they did with the floods.
+template<typename WeightFunc> static void SplitGraph_MultiSourceOwnershipImpl(const pointIndexList& roots, std::vector<VertexInfo>& vertexInfo, const fullNeighbourList& neighbours, WeightFunc getWeight)
+{
+    for( size_t i=0; i<vertexInfo.size(); i++ )
+    {
+        vertexInfo[i].closed = false;
+        vertexInfo[i].lowestWeight = FLT_MAX;
+        vertexInfo[i].parentIndex = -1;
+    }
+
+    IndexedPriorityQueue openList;
+    openList.Reset( vertexInfo.size() );
+
+    for( size_t i=0; i<roots.size(); i++ )
+    {
+        // If the same vertex was picked as a root twice, it stays with the first one.
+        if( openList.Contains( roots[i] ) )
+            continue;
+
+        vertexInfo[roots[i]].lowestWeight = 0;
+        vertexInfo[roots[i]].owner = i+1;
+        openList.PushOrDecrease( roots[i], 0 );
+    }
+
+    while( openList.IsEmpty() == false )
+    {
+        vertIndex currentIndex = openList.PopMin();
+        vertexInfo[currentIndex].closed = true;
+
+        for( const vertIndex nIndex : neighbours[currentIndex] )
+        {
+            if( vertexInfo[nIndex].closed )
+                continue;
+
+            edgeWeight totalWeight = vertexInfo[currentIndex].lowestWeight + getWeight( currentIndex, nIndex );
+
+            if( totalWeight < vertexInfo[nIndex].lowestWeight ||
+                ( totalWeight == vertexInfo[nIndex].lowestWeight && vertexInfo[currentIndex].owner < vertexInfo[nIndex].owner ) )
+            {
+                vertexInfo[nIndex].lowestWeight = totalWeight;
+                vertexInfo[nIndex].owner = vertexInfo[currentIndex].owner;
+                vertexInfo[nIndex].parentIndex = currentIndex;
+
+                openList.PushOrDecrease( nIndex, totalWeight );
+            }
+        }
+    }
+}
+
+// Parallel version of SplitGraph_MultiSourceOwnershipImpl using delta-stepping.
+// Open vertices are grouped into buckets 'delta' wide by weight, and all vertices in the lowest bucket are expanded at once across threads.
+// Each vertex's weight and owner are packed into one atomic so threads can lower both together, the final labels don't depend on
+//   the order threads ran in, so the result is the same as the single threaded version apart from which parent is picked on ties.
+// Weights must not be negative. A delta of 0 or less uses the average edge weight.
+template<typename WeightFunc> static void SplitGraph_MultiSourceOwnershipParallelImpl(const pointIndexList& roots, std::vector<VertexInfo>& vertexInfo, const fullNeighbourList& neighbours, WeightFunc getWeight, float delta)
+{
+    size_t numVerts = vertexInfo.size();
+
+    // Non-negative floats sort the same way as their bits, so packed labels compare by weight first and by owner second.
+    auto packLabel = [](edgeWeight weight, uint32 owner) -> uint64
+    {
+        uint32 bits;
+        memcpy( &bits, &weight, sizeof(bits) );
+        return ((uint64)bits << 32) | owner;
+    };
+    auto labelWeight = [](uint64 label) -> edgeWeight
+    {
+        uint32 bits = (uint32)(label >> 32);
+        edgeWeight weight;
+        memcpy( &weight, &bits, sizeof(weight) );
+        return weight;
+    };
+    const uint64 unreached = ~0ull;
+
+    std::vector<std::atomic<uint64>> labels( numVerts );
+    for( size_t i=0; i<numVerts; i++ )
+    {
+        labels[i].store( unreached, std::memory_order_relaxed );
+    }
 
-                    // Insert into open list sorted in descending order.
+    if( delta <= 0 )
+    {
+        double totalWeight = 0;
+        size_t numEdges = 0;
+        for( vertIndex v=0; v<numVerts; v++ )
+        {
+            for( const vertIndex n : neighbours[v] )
+            {
+                totalWeight += getWeight( v, n );
+                numEdges++;
+            }
+        }
+        delta = numEdges > 0 ? (float)(totalWeight / numEdges) : 1.0f;
+        if( delta <= 0 )
+            delta = 1.0f;
+    }
+
+    // Only non-empty buckets are stored, keyed by index. With skewed weights the highest index can be huge compared to
+    //   how many buckets are ever used, so a dense array could take a lot of memory and time to step through.
+    std::map<size_t, vertIndexList> buckets;
+    auto bucketOf = [&](vertIndex v) -> size_t
+    {
+        return (size_t)( labelWeight( labels[v].load( std::memory_order_relaxed ) ) / delta );
+    };
+    auto addToBucket = [&](vertIndex v)
+    {
+        buckets[bucketOf( v )].push_back( v );
+    };
+
+    for( size_t i=0; i<roots.size(); i++ )
+    {
+        uint64 label = packLabel( 0, (uint32)(i+1) );
+        if( label < labels[roots[i]].load( std::memory_order_relaxed ) )
+        {
+            labels[roots[i]].store( label, std::memory_order_relaxed );
+            addToBucket( roots[i] );
+        }
+    }
+
+    // Each chunk of the frontier collects the vertices it lowered in its own list.
+    const int numChunks = 64;
+    std::vector<vertIndexList> loweredPerChunk( numChunks );
+    std::vector<uint32> frontierStamp( numVerts, 0 );
+    uint32 stamp = 0;
+
+    vertIndexList candidates;
+    vertIndexList frontier;
+    // Expanding a bucket only adds vertices to the same or later buckets, so the lowest one left is always next.
+    while( buckets.empty() == false )
+    {
+        size_t b = buckets.begin()->first;
+        candidates.swap( buckets.begin()->second );
+        buckets.erase( buckets.begin() );
+
+        // Vertices lowered to a weight still inside this bucket have to be expanded again before moving on.
+        while( candidates.size() > 0 )
+        {
+            // Drop duplicates and vertices that were since lowered into an earlier part of the list.
+            stamp++;
+            frontier.clear();
+            for( const vertIndex v : candidates )
+            {
+                if( frontierStamp[v] != stamp && bucketOf( v ) == b )
+                {
+                    frontierStamp[v] = stamp;
+                    frontier.push_back( v );
+                }
+            }
+            candidates.clear();
+
+            int chunkCount = (int)std::min( (size_t)numChunks, frontier.size() );
+            size_t chunkSize = (frontier.size() + chunkCount - 1) / std::max( chunkCount, 1 );
+
+            cv::parallel_for_( cv::Range( 0, chunkCount ), [&](const cv::Range& range)
+            {
+                for( int c=range.start; c<range.end; c++ )
+                {
+                    vertIndexList& lowered = loweredPerChunk[c];
+                    size_t end = std::min( frontier.size(), (c+1) * chunkSize );
+                    for( size_t f=c*chunkSize; f<end; f++ )
                     {
-                        bool inserted = false;
-                        for( size_t i=0; i<openList.size(); i++ )
+                        vertIndex v = frontier[f];
+                        uint64 label = labels[v].load( std::memory_order_relaxed );
+                        edgeWeight weight = labelWeight( label );
+                        uint32 owner = (uint32)label;
+
+                        for( const vertIndex n : neighbours[v] )
                         {
-                            if( totalWeight > vertexInfo[openList[i]].lowestWeight )
+                            uint64 newLabel = packLabel( weight + getWeight( v, n ), owner );
+                            uint64 oldLabel = labels[n].load( std::memory_order_relaxed );
+                            while( newLabel < oldLabel )
                             {
-                                inserted = true;
-                                openList.insert( openList.begin() + i, nIndex );
-                                break;
+                                if( labels[n].compare_exchange_weak( oldLabel, newLabel, std::memory_order_relaxed ) )
+                                {
+                                    lowered.push_back( n );
+                                    break;
+                                }
                             }
                         }
-
-                        // If the list was empty or we didn't find a shorter path,
-                        // insert the element at the end of the list.
-                        if( inserted == false )
-                        {
-                            openList.push_back( nIndex );
-                        }
                     }
+                }
+            } );
 
-                    // Set the new parent.
-                    vertexInfo[nIndex].parentIndex = currentIndex;
+            for( int c=0; c<chunkCount; c++ )
+            {
+                for( const vertIndex n : loweredPerChunk[c] )
+                {
+                    if( bucketOf( n ) == b )
+                        candidates.push_back( n );
+                    else
+                        addToBucket( n );
                 }
+                loweredPerChunk[c].clear();
             }
         }
     }
+
+    // A neighbour with the same owner is where v's label could have come from if its weight plus the edge gives v's weight.
+    auto isTightEdge = [&](vertIndex n, vertIndex v, uint64 label) -> bool
+    {
+        uint64 nLabel = labels[n].load( std::memory_order_relaxed );
+        if( nLabel == unreached || (uint32)nLabel != (uint32)label )
+            return false;
+
+        return packLabel( labelWeight( nLabel ) + getWeight( n, v ), (uint32)label ) == label;
+    };
+
+    // Unpack the labels and pick a parent for each vertex, the lowest index neighbour that the label came from.
+    // Only neighbours with a strictly lower weight are used here, so following parents always goes downhill and can't loop.
+    // Vertices only reachable over zero weight edges are left for the pass below.
+    std::vector<uint8> needsParent( numVerts, 0 );
+    cv::parallel_for_( cv::Range( 0, (int)numVerts ), [&](const cv::Range& range)
+    {
+        for( int i=range.start; i<range.end; i++ )
+        {
+            vertIndex v = i;
+            uint64 label = labels[v].load( std::memory_order_relaxed );
+
+            vertexInfo[v].closed = false;
+            vertexInfo[v].parentIndex = -1;
+            if( label == unreached )
+            {
+                vertexInfo[v].lowestWeight = FLT_MAX;
+                continue;
+            }
+
+            uint32 owner = (uint32)label;
+            edgeWeight weight = labelWeight( label );
+            vertexInfo[v].lowestWeight = weight;
+            vertexInfo[v].owner = owner;
+            vertexInfo[v].closed = true;
+
+            if( roots[owner-1] == v && weight == 0 )
+                continue;
+
+            for( const vertIndex n : neighbours[v] )
+            {
+                if( n < vertexInfo[v].parentIndex && labelWeight( labels[n].load( std::memory_order_relaxed ) ) < weight && isTightEdge( n, v, label ) )
+                {
+                    vertexInfo[v].parentIndex = n;
+                }
+            }
+
+            if( vertexInfo[v].parentIndex == -1 )
+            {
+                needsParent[v] = 1;
+            }
+        }
+    } );
+
+    // Whatever is left sits on a flat run of zero weight edges, spread parents outward from the vertices that already have one.
+    // Parents only ever point at vertices that already have a complete chain to a root, so no loops can form.
+    vertIndexList openList;
+    auto spreadParents = [&](auto canBeParent)
+    {
+        for( vertIndex v=0; v<numVerts; v++ )
+        {
+            if( needsParent[v] == 0 )
+                continue;
+
+            for( const vertIndex n : neighbours[v] )
+            {
+                if( needsParent[n] == 0 && n < vertexInfo[v].parentIndex && canBeParent( n, v ) )
+                {
+                    vertexInfo[v].parentIndex = n;
+                }
+            }
+
+            if( vertexInfo[v].parentIndex != -1 )
+            {
+                vertexInfo[v].owner = vertexInfo[vertexInfo[v].parentIndex].owner;
+                needsParent[v] = 0;
+                openList.push_back( v );
+            }
+        }
+
+        while( openList.size() > 0 )
+        {
+            vertIndex currentIndex = openList[openList.size()-1];
+            openList.pop_back();
+
+            for( const vertIndex nIndex : neighbours[currentIndex] )
+            {
+                if( needsParent[nIndex] && canBeParent( currentIndex, nIndex ) )
+                {
+                    vertexInfo[nIndex].parentIndex = currentIndex;
+                    vertexInfo[nIndex].owner = vertexInfo[currentIndex].owner;
+                    needsParent[nIndex] = 0;
+                    openList.push_back( nIndex );
+                }
+            }
+        }
+    };
+
+    spreadParents( [&](vertIndex n, vertIndex v)
+    {
+        return isTightEdge( n, v, labels[v].load( std::memory_order_relaxed ) );
+    } );
+
+    // Rounding can leave a vertex whose owner no neighbour reproduces, when another owner lowered the neighbour its label came
+    //   from but the new total rounded to the same weight, so never replaced it. Any neighbour that gives the same weight is
+    //   an equally short path, so take it as the parent and adopt its owner.
+    spreadParents( [&](vertIndex n, vertIndex v)
+    {
+        return vertexInfo[n].closed && vertexInfo[n].lowestWeight + getWeight( n, v ) == vertexInfo[v].lowestWeight;
+    } );
+}
+
+void SplitGraph_BFSFloodFillOwnership(treeIndex owner, vertIndex startIndex, std::vector<VertexInfo>& vertexInfo, const fullNeighbourList& neighbours, const fullEdgeList& edgeList, const linearWeightedEdgeList& activeEdges)
+{
+    SplitGraph_BFSFloodFillOwnershipImpl( owner, startIndex, vertexInfo, neighbours, [&](vertIndex v1, vertIndex v2)
+    {
+        return edgeList.at( std::min( v1, v2 ) ).at( std::max( v1, v2 ) );
+    } );
 }
 
-// TODO: This is very inefficient, some space partioning might do wonders.
+// Linear scan, use a SpatialIndex when doing more than a few queries on the same points.
 vertIndex FindNearestVertexToPoint(const pointList& points, vec2 point)
 {
     if( points.size() == 0 )
@@ -693,11 +1495,10 @@ vertIndex FindNearestVertexToPoint(const pointList& points, vec2 point)
     return closestIndex;
 }
 
-linearWeightedEdgeList SplitGraph(std::vector<VertexInfo>& vertexInfo, const Graph& graph, const linearWeightedEdgeList& activeEdges, int numSplits, const pointList& treeRoots)
+template<typename GraphType> static linearWeightedEdgeList SplitGraphImpl(std::vector<VertexInfo>& vertexInfo, const GraphType& graph, const linearWeightedEdgeList& activeEdges, int numSplits, const pointList& treeRoots, RandomStream& stream)
 {
     linearWeightedEdgeList edges;
 
-    assert( graph.points.size() == graph.neighbours.size() );
     size_t numVerts = graph.points.size();
 
     // Build a neighbour list for active edges.
@@ -718,50 +1519,78 @@ linearWeightedEdgeList SplitGraph(std::vector<VertexInfo>& vertexInfo, const Gra
         // Pick some random roots.
         for( int i=0; i<numSplits-1; i++ )
         {
-            starts.push_back( randSizeT(0, numVerts-1) );
+            starts.push_back( stream.NextSizeT( 0, numVerts-1 ) );
         }
     }
     else
     {
         // Find nearest vertex to each treeRoot.
+        SpatialIndex index;
+        index.Build( graph.points );
         for( size_t i=0; i<treeRoots.size(); i++ )
         {
-            vertIndex vi = FindNearestVertexToPoint( graph.points, treeRoots[i] );
+            vertIndex vi = index.FindNearestPoint( treeRoots[i] ).first;
             starts.push_back( vi );
         }
     }
 
-    for( size_t i=0; i<starts.size(); i++ )
+    // Every root is grown at once, large graphs spread the search across threads.
+    auto getWeight = [&](vertIndex v1, vertIndex v2)
     {
-        SplitGraph_BFSFloodFillOwnership( (int)i+1, starts[i], vertexInfo, activeNeighbours, graph.weights, activeEdges );
-    }
+        return graph.GetWeight( v1, v2 );
+    };
 
-    for( size_t i=0; i<graph.points.size(); i++ )
+    const size_t parallelVertexCount = 1 << 18;
+    if( numVerts >= parallelVertexCount )
+    {
+        SplitGraph_MultiSourceOwnershipParallelImpl( starts, vertexInfo, activeNeighbours, getWeight, 0 );
+    }
+    else
     {
-        const neighbourList& currentNeighbours = activeNeighbours[i];
+        SplitGraph_MultiSourceOwnershipImpl( starts, vertexInfo, activeNeighbours, getWeight );
+    }
 
-        for( const vertIndex n : currentNeighbours )
+    // Keep the active edges that stay inside one region, with their weights.
+    for( const weightedEdge& edge : activeEdges )
+    {
+        if( vertexInfo[std::get<EdgeIndex1>( edge )].owner == vertexInfo[std::get<EdgeIndex2>( edge )].owner )
         {
-            if( i < n )
-            {
-                if( vertexInfo[i].owner == vertexInfo[n].owner )
-                {
-                    edges.push_back( { 1.0f, i, n } ); // TODO: Fix the 1.0f.
-                }
-            }
+            edges.push_back( edge );
         }
     }
 
     return edges;
 }
 
-vertIndex FindNextNeighbourClockwiseFromIndex(const pointList& points, const pointIndexList& validVerts, const neighbourList& neighbours, vec2 pointPos, vec2 previousPos)
+linearWeightedEdgeList SplitGraph(std::vector<VertexInfo>& vertexInfo, const Graph& graph, const linearWeightedEdgeList& activeEdges, int numSplits, const pointList& treeRoots, RandomStream& stream)
 {
-    // Get dir and angle to previous point.
-    vec2 startDir = previousPos - pointPos;
-    float startAngle = atan2f( -startDir.y, startDir.x );
-    if( startAngle < 0 )
-        startAngle += 2*PI;
+    return SplitGraphImpl( vertexInfo, graph, activeEdges, numSplits, treeRoots, stream );
+}
+
+linearWeightedEdgeList SplitGraph(std::vector<VertexInfo>& vertexInfo, const CSRGraph& graph, const linearWeightedEdgeList& activeEdges, int numSplits, const pointList& treeRoots, RandomStream& stream)
+{
+    return SplitGraphImpl( vertexInfo, graph, activeEdges, numSplits, treeRoots, stream );
+}
+
+// Stand-in for atan2f( -dir.y, dir.x ) wrapped to [0, 2*PI), but in [0, 4) and without any trig.
+// It goes up with the real angle, so it can only be used to compare angles.
+static float PseudoAngle(vec2 dir)
+{
+    float x = dir.x;
+    float y = -dir.y;
+
+    float sum = fabsf( x ) + fabsf( y );
+    if( sum == 0 )
+        return 0;
+
+    float p = x / sum;
+    return y < 0 ? 3 + p : 1 - p;
+}
+
+template<typename ValidFunc> static vertIndex FindNextNeighbourClockwiseFromIndexImpl(const pointList& points, const neighbourList& neighbours, vec2 pointPos, vec2 previousPos, ValidFunc isValid)
+{
+    // Get angle to previous point.
+    float startAngle = PseudoAngle( previousPos - pointPos );
 
     // Find next clockwise neighbour.
     float largestAngle = -FLT_MAX;
@@ -769,17 +1598,12 @@ vertIndex FindNextNeighbourClockwiseFromIndex(const pointList& points, const poi
     for( const vertIndex nIndex : neighbours )
     {
         // Ensure the neighbour is in the boundary list.
-        auto itBoundary = std::find( validVerts.begin(), validVerts.end(), nIndex );
-        if( itBoundary == validVerts.end() )
+        if( isValid( nIndex ) == false )
             continue;
 
-        vec2 dir = points[nIndex] - pointPos;
-        float angle = atan2f( -dir.y, dir.x );
-        if( angle < 0 )
-            angle += 2*PI;
-        float angleDiff = angle - startAngle;
+        float angleDiff = PseudoAngle( points[nIndex] - pointPos ) - startAngle;
         if( angleDiff < 0 )
-            angleDiff += 2*PI;
+            angleDiff += 4;
 
         if( angleDiff >= largestAngle )
         {
@@ -791,6 +1615,22 @@ vertIndex FindNextNeighbourClockwiseFromIndex(const pointList& points, const poi
     return largestIndex;
 }
 
+vertIndex FindNextNeighbourClockwiseFromIndex(const pointList& points, const pointIndexList& validVerts, const neighbourList& neighbours, vec2 pointPos, vec2 previousPos)
+{
+    return FindNextNeighbourClockwiseFromIndexImpl( points, neighbours, pointPos, previousPos, [&](vertIndex nIndex)
+    {
+        return std::find( validVerts.begin(), validVerts.end(), nIndex ) != validVerts.end();
+    } );
+}
+
+vertIndex FindNextNeighbourClockwiseFromIndex(const pointList& points, const std::vector<bool>& isValidVert, const neighbourList& neighbours, vec2 pointPos, vec2 previousPos)
+{
+    return FindNextNeighbourClockwiseFromIndexImpl( points, neighbours, pointPos, previousPos, [&](vertIndex nIndex)
+    {
+        return isValidVert[nIndex];
+    } );
+}
+
 pointIndexList BuildBoundaryVertexList(treeIndex treeLabel, const pointList& points, const fullNeighbourList& neighbours, const std::vector<VertexInfo>& vertexInfo)
 {
     pointIndexList boundaryVerts;
@@ -817,6 +1657,13 @@ pointIndexList BuildBoundaryVertexList(treeIndex treeLabel, const pointList& poi
 
 pointIndexList BuildBoundaryVertexList_Method2(treeIndex treeLabel, const pointList& points, const fullNeighbourList& neighbours, const std::vector<VertexInfo>& vertexInfo, const vertIndexList& vertsInRegion)
 {
+    // Flag the region's verts once so each neighbour check is a lookup.
+    std::vector<bool> inRegion( points.size(), false );
+    for( const vertIndex v : vertsInRegion )
+    {
+        inRegion[v] = true;
+    }
+
     pointIndexList boundaryVerts;
     for( size_t i=0; i<vertsInRegion.size(); i++ )
     {
@@ -825,7 +1672,7 @@ pointIndexList BuildBoundaryVertexList_Method2(treeIndex treeLabel, const pointL
         for( const vertIndex nIndex : currentNeighbours )
         {
             // If the neighbour is inside our region, go to the next one.
-            if( std::find( vertsInRegion.begin(), vertsInRegion.end(), nIndex ) != vertsInRegion.end() )
+            if( inRegion[nIndex] )
                 continue;
 
             // If a neighbour isn't in our tree, this is a boundary vert.
@@ -840,6 +1687,100 @@ pointIndexList BuildBoundaryVertexList_Method2(treeIndex treeLabel, const pointL
     return boundaryVerts;
 }
 
+labelList CreateLabelListFromOwners(const std::vector<VertexInfo>& vertexInfo)
+{
+    labelList labels( vertexInfo.size() );
+    for( size_t i=0; i<vertexInfo.size(); i++ )
+    {
+        labels[i] = vertexInfo[i].owner;
+    }
+
+    return labels;
+}
+
+std::vector<pointIndexList> BuildBoundaryVertexLists(const labelList& labels, const fullNeighbourList& neighbours, size_t numLabels)
+{
+    std::vector<pointIndexList> boundaryVerts( numLabels );
+
+    for( vertIndex i=0; i<labels.size(); i++ )
+    {
+        if( labels[i] >= numLabels )
+            continue;
+
+        for( const vertIndex nIndex : neighbours[i] )
+        {
+            // If a neighbour has another label, this is a boundary vert.
+            if( labels[nIndex] != labels[i] )
+            {
+                boundaryVerts[labels[i]].push_back( i );
+                break;
+            }
+        }
+    }
+
+    return boundaryVerts;
+}
+
+std::vector<std::pair<treeIndex, pointIndexList>> TraceRegionBoundaries(const delaunator::Delaunator& triangulation, const labelList& labels)
+{
+    std::vector<std::pair<treeIndex, pointIndexList>> loops;
+
+    const std::vector<size_t>& triangles = triangulation.triangles;
+    const std::vector<size_t>& halfedges = triangulation.halfedges;
+    size_t numHalfEdges = triangles.size();
+
+    // Half-edge e goes from triangles[e] to triangles[NextHalfEdge(e)], the three half-edges of a triangle are next to each other.
+    auto nextHalfEdge = [](size_t e) { return (e % 3 == 2) ? e - 2 : e + 1; };
+
+    // A triangle is part of a region if all 3 corners have the same label.
+    auto triangleLabel = [&](size_t e) -> treeIndex
+    {
+        size_t first = e - e % 3;
+        treeIndex label = labels[triangles[first]];
+        if( labels[triangles[first+1]] != label || labels[triangles[first+2]] != label )
+            return (treeIndex)-1;
+        return label;
+    };
+
+    // Boundary half-edges are inside a region's triangle but aren't shared with another triangle of the same region.
+    auto isBoundary = [&](size_t e)
+    {
+        treeIndex label = triangleLabel( e );
+        if( label == -1 )
+            return false;
+
+        size_t twin = halfedges[e];
+        return twin == -1 || triangleLabel( twin ) != label;
+    };
+
+    std::vector<bool> visited( numHalfEdges, false );
+    for( size_t start=0; start<numHalfEdges; start++ )
+    {
+        if( visited[start] || isBoundary( start ) == false )
+            continue;
+
+        pointIndexList loop;
+        size_t e = start;
+        do
+        {
+            visited[e] = true;
+            loop.push_back( triangles[e] );
+
+            // Turn around the end vertex through the region's triangles until reaching the next boundary half-edge.
+            size_t next = nextHalfEdge( e );
+            while( isBoundary( next ) == false )
+            {
+                next = nextHalfEdge( halfedges[next] );
+            }
+            e = next;
+        } while( e != start );
+
+        loops.push_back( { triangleLabel( start ), loop } );
+    }
+
+    return loops;
+}
+
 vertIndex FindTopmostPointIndex(const pointList& points, const pointIndexList& allowedVerts)
 {
     // 0,0 is at top left.
@@ -858,21 +1799,17 @@ vertIndex FindTopmostPointIndex(const pointList& points, const pointIndexList& a
     return smallestIndex;
 }
 
-vertIndexList CreateGroupOfVertsNotBlockedByVertices(const Graph& graph, std::vector<VertexInfo>& vertexInfo, const vertIndexList& blockers, const vertIndex startIndex)
+template<typename GraphType> static vertIndexList CreateGroupOfVertsNotBlockedByVerticesImpl(const GraphType& graph, const std::vector<VertexInfo>& vertexInfo, SearchWorkspace& workspace, const vertIndexList& blockers, const vertIndex startIndex)
 {
     vertIndexList connectedVerts;
 
-    // Init vertexInfo struct for each vertex.
-    // Only used for closed flag. // TODO: Could easily be more efficient with a bit array.
-    for( size_t i=0; i<graph.points.size(); i++ )
-    {
-        vertexInfo[i].closed = false;
-    }
+    // Only the closed flags are used, a new search leaves every vertex open without touching them all.
+    workspace.BeginSearch( graph.points.size() );
 
     // Set all blocked verts to be closed.
     for( size_t i=0; i<blockers.size(); i++ )
     {
-        vertexInfo[blockers[i]].closed = true;
+        workspace.SetClosed( blockers[i] );
     }
 
     // Open list, no sorting.
@@ -887,13 +1824,13 @@ vertIndexList CreateGroupOfVertsNotBlockedByVertices(const Graph& graph, std::ve
         // Grab the last element of the open list, which is the lowest weight vertex.
         vertIndex currentIndex = openList[openList.size()-1];
         openList.pop_back();
-        vertexInfo[currentIndex].closed = true;
+        workspace.SetClosed( currentIndex );
 
         // Loop through neighbours.
-        for( const vertIndex nIndex : graph.neighbours[currentIndex] )
+        for( const vertIndex nIndex : graph.GetNeighbours( currentIndex ) )
         {
             // If the neighbour is closed, skip over it.
-            if( vertexInfo[nIndex].closed )
+            if( workspace.IsClosed( nIndex ) )
                 continue;
 
             // If the verts aren't part of the same region.
@@ -908,19 +1845,60 @@ vertIndexList CreateGroupOfVertsNotBlockedByVertices(const Graph& graph, std::ve
     return connectedVerts;
 }
 
-vertIndexList CreateListOfVertsWithinStepsOfVertex(const Graph& graph, std::vector<VertexInfo>& vertexInfo, const vertIndex startIndex, float maxWeight)
+vertIndexList CreateGroupOfVertsNotBlockedByVertices(const Graph& graph, std::vector<VertexInfo>& vertexInfo, const vertIndexList& blockers, const vertIndex startIndex)
+{
+    return CreateGroupOfVertsNotBlockedByVerticesImpl( graph, vertexInfo, SearchWorkspace::GetThreadLocal(), blockers, startIndex );
+}
+
+vertIndexList CreateGroupOfVertsNotBlockedByVertices(const CSRGraph& graph, std::vector<VertexInfo>& vertexInfo, const vertIndexList& blockers, const vertIndex startIndex)
+{
+    return CreateGroupOfVertsNotBlockedByVerticesImpl( graph, vertexInfo, SearchWorkspace::GetThreadLocal(), blockers, startIndex );
+}
+
+vertIndexList CreateGroupOfVertsNotBlockedByVertices(const Graph& graph, const std::vector<VertexInfo>& vertexInfo, SearchWorkspace& workspace, const vertIndexList& blockers, const vertIndex startIndex)
+{
+    return CreateGroupOfVertsNotBlockedByVerticesImpl( graph, vertexInfo, workspace, blockers, startIndex );
+}
+
+vertIndexList CreateGroupOfVertsNotBlockedByVertices(const CSRGraph& graph, const std::vector<VertexInfo>& vertexInfo, SearchWorkspace& workspace, const vertIndexList& blockers, const vertIndex startIndex)
+{
+    return CreateGroupOfVertsNotBlockedByVerticesImpl( graph, vertexInfo, workspace, blockers, startIndex );
+}
+
+template<typename GraphType> static vertIndexList CreateListOfVertsWithinStepsOfVertexImpl(const GraphType& graph, std::vector<VertexInfo>& vertexInfo, SearchWorkspace* pWorkspace, const vertIndex startIndex, float maxWeight)
 {
     vertIndexList verts;
 
     int flags = DijkstraSearchObject::DBF_ForceSameOwnership | DijkstraSearchObject::DBF_CheckWeights;
     DijkstraSearchObject dso( graph, vertexInfo, startIndex, (DijkstraSearchObject::DijkstraBitFlags)flags );
     dso.m_MaxWeight = maxWeight;
+    dso.m_pWorkspace = pWorkspace;
     verts = dso.Search();
 
     return verts;
 }
 
-vertIndexList CreateListOfVertsWithinRadiusOfVertex(const Graph& graph, vertIndex center, float radius)
+vertIndexList CreateListOfVertsWithinStepsOfVertex(const Graph& graph, std::vector<VertexInfo>& vertexInfo, const vertIndex startIndex, float maxWeight)
+{
+    return CreateListOfVertsWithinStepsOfVertexImpl( graph, vertexInfo, &SearchWorkspace::GetThreadLocal( SearchWorkspace::LocalSearchSlot ), startIndex, maxWeight );
+}
+
+vertIndexList CreateListOfVertsWithinStepsOfVertex(const CSRGraph& graph, std::vector<VertexInfo>& vertexInfo, const vertIndex startIndex, float maxWeight)
+{
+    return CreateListOfVertsWithinStepsOfVertexImpl( graph, vertexInfo, &SearchWorkspace::GetThreadLocal( SearchWorkspace::LocalSearchSlot ), startIndex, maxWeight );
+}
+
+vertIndexList CreateListOfVertsWithinStepsOfVertex(const Graph& graph, std::vector<VertexInfo>& vertexInfo, SearchWorkspace& workspace, const vertIndex startIndex, float maxWeight)
+{
+    return CreateListOfVertsWithinStepsOfVertexImpl( graph, vertexInfo, &workspace, startIndex, maxWeight );
+}
+
+vertIndexList CreateListOfVertsWithinStepsOfVertex(const CSRGraph& graph, std::vector<VertexInfo>& vertexInfo, SearchWorkspace& workspace, const vertIndex startIndex, float maxWeight)
+{
+    return CreateListOfVertsWithinStepsOfVertexImpl( graph, vertexInfo, &workspace, startIndex, maxWeight );
+}
+
+template<typename GraphType> static vertIndexList CreateListOfVertsWithinRadiusOfVertexImpl(const GraphType& graph, vertIndex center, float radius)
 {
     assert( center < graph.points.size() );
 
@@ -940,32 +1918,80 @@ vertIndexList CreateListOfVertsWithinRadiusOfVertex(const Graph& graph, vertInde
     return verts;
 }
 
+vertIndexList CreateListOfVertsWithinRadiusOfVertex(const Graph& graph, vertIndex center, float radius)
+{
+    return CreateListOfVertsWithinRadiusOfVertexImpl( graph, center, radius );
+}
+
+vertIndexList CreateListOfVertsWithinRadiusOfVertex(const CSRGraph& graph, vertIndex center, float radius)
+{
+    return CreateListOfVertsWithinRadiusOfVertexImpl( graph, center, radius );
+}
+
+// Only the two vertices and their neighbours can reference v1 or v2, so only those lists are patched.
 void Graph_SwapIndex(std::vector<vec2>& pointList, fullNeighbourList& neighbours, vertIndex v1, vertIndex v2)
 {
     if( v1 == v2 )
         return;
 
-    vec2 temp = pointList[v1];
-    pointList[v1] = pointList[v2];
-    pointList[v2] = temp;
+    // Gather the lists to patch first, a vertex next to both v1 and v2 is only patched once.
+    vertIndexList touched( neighbours[v1].begin(), neighbours[v1].end() );
+    for( vertIndex i : neighbours[v2] )
+    {
+        if( neighbours[v1].count( i ) == 0 )
+            touched.push_back( i );
+    }
+
+    for( vertIndex i : touched )
+    {
+        bool hadV1 = neighbours[i].erase( v1 ) > 0;
+        bool hadV2 = neighbours[i].erase( v2 ) > 0;
+        if( hadV1 ) neighbours[i].insert( v2 );
+        if( hadV2 ) neighbours[i].insert( v1 );
+    }
+
+    std::swap( pointList[v1], pointList[v2] );
+    std::swap( neighbours[v1], neighbours[v2] );
+}
 
-    neighbourList tempNeighbours = neighbours[v1];
-    neighbours[v1] = neighbours[v2];
-    neighbours[v2] = tempNeighbours;
+// newIndices[oldIndex] is where each vertex ends up, or -1 to drop it along with all edges to it.
+// The kept vertices must map onto 0 to n-1 with no gaps or duplicates.
+void Graph_ApplyPermutation(std::vector<vec2>& pointList, fullNeighbourList& neighbours, const vertIndexList& newIndices)
+{
+    assert( newIndices.size() == pointList.size() );
+    assert( neighbours.size() == pointList.size() );
 
-    for( size_t i=0; i<neighbours.size(); i++ )
+    size_t numKept = 0;
+    for( vertIndex newIndex : newIndices )
     {
-        if( neighbours[i].count(v1) )
-        {
-            neighbours[i].erase( v1 );
-            neighbours[i].insert( v2 );
-        }
-        else if( neighbours[i].count(v2) )
+        if( newIndex != (vertIndex)-1 )
+            numKept++;
+    }
+
+    std::vector<vec2> newPointList( numKept );
+    fullNeighbourList newNeighbours( numKept );
+
+    for( size_t i=0; i<pointList.size(); i++ )
+    {
+        vertIndex newIndex = newIndices[i];
+        if( newIndex == (vertIndex)-1 )
+            continue;
+
+        assert( newIndex < numKept );
+
+        newPointList[newIndex] = pointList[i];
+
+        neighbourList& newList = newNeighbours[newIndex];
+        newList.reserve( neighbours[i].size() );
+        for( vertIndex neighbour : neighbours[i] )
         {
-            neighbours[i].erase( v2 );
-            neighbours[i].insert( v1 );
+            if( newIndices[neighbour] != (vertIndex)-1 )
+                newList.insert( newIndices[neighbour] );
         }
     }
+
+    pointList.swap( newPointList );
+    neighbours.swap( newNeighbours );
 }
 
 void Graph_RemovePoint(std::vector<vec2>& pointList, fullNeighbourList& neighbours, vertIndex indexToRemove)
@@ -978,29 +2004,38 @@ void Graph_RemovePoint(std::vector<vec2>& pointList, fullNeighbourList& neighbou
         neighbours[i].erase( indexToRemove );
     }
 
-    pointList[indexToRemove] = pointList[lastVertIndex];
-    neighbours[indexToRemove] = neighbours[lastVertIndex];
-
-    // Point the edge from all neighbours to the new index.
-    for( size_t i : neighbours[indexToRemove] )
+    // Move the last vertex into the hole and point the edges from all its neighbours to the new index.
+    if( indexToRemove != lastVertIndex )
     {
-        neighbours[i].erase( lastVertIndex );
-        neighbours[i].insert( indexToRemove );
-    }
+        pointList[indexToRemove] = pointList[lastVertIndex];
+        neighbours[indexToRemove].swap( neighbours[lastVertIndex] );
 
-    //// If any neighbour has this one as a neighbour, fix it.
-    //for( size_t i=0; i<neighbours.size(); i++ )
-    //{
-    //    if( neighbours[i].count(lastVertIndex) )
-    //    {
-    //        neighbours[i].erase( lastVertIndex );
-    //        if( indexToRemove != lastVertIndex )
-    //        {
-    //            neighbours[i].insert( indexToRemove );
-    //        }
-    //    }
-    //}
+        for( size_t i : neighbours[indexToRemove] )
+        {
+            neighbours[i].erase( lastVertIndex );
+            neighbours[i].insert( indexToRemove );
+        }
+    }
 
     pointList.pop_back();
     neighbours.pop_back();
 }
+
+// Removes many points in one pass, the remaining points keep their relative order.
+void Graph_RemovePoints(std::vector<vec2>& pointList, fullNeighbourList& neighbours, const vertIndexList& indicesToRemove)
+{
+    vertIndexList newIndices( pointList.size(), 0 );
+    for( vertIndex i : indicesToRemove )
+    {
+        newIndices[i] = (vertIndex)-1;
+    }
+
+    vertIndex nextIndex = 0;
+    for( size_t i=0; i<newIndices.size(); i++ )
+    {
+        if( newIndices[i] != (vertIndex)-1 )
+            newIndices[i] = nextIndex++;
+    }
+
+    Graph_ApplyPermutation( pointList, neighbours, newIndices );
+}
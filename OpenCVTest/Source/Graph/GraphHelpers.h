@@ -8,6 +8,16 @@ namespace delaunator
     class Delaunator;
 }
 
+class SearchWorkspace;
+
+enum class MSTAlgorithm
+{
+    Prim,       // Grows one tree from vertex 0, only covers vertex 0's connected part of the graph.
+    Kruskal,    // Sorted edges joined with union-find, gives a tree for every connected part.
+    Boruvka,    // Every tree picks its cheapest outgoing edge at once, split across threads. Same result as Kruskal.
+    NumTypes,
+};
+
 class Graph
 {
 public:
@@ -18,6 +28,68 @@ public:
     void Clear();
     //void operator+=(const Graph& o);
     bool PointHasNeighbour(vertIndex point, vertIndex neighbourToTestFor) const;
+
+    // Same accessors as CSRGraph, so the helpers below can be written once for both.
+    size_t GetVertexCount() const { return points.size(); }
+    const neighbourList& GetNeighbours(vertIndex point) const { return neighbours[point]; }
+    edgeWeight GetWeight(vertIndex v1, vertIndex v2) const { return weights.at( std::min( v1, v2 ) ).at( std::max( v1, v2 ) ); }
+
+    template<typename Func> void ForEachWeightedNeighbour(vertIndex point, Func func) const
+    {
+        for( const vertIndex n : neighbours[point] )
+        {
+            func( n, GetWeight( point, n ) );
+        }
+    }
+};
+
+// Compressed sparse row adjacency, built once from a Graph or a neighbour list and then only read.
+// The neighbours of vertex v are neighbours[offsets[v]] up to neighbours[offsets[v+1]], sorted, and each edge's weight
+//   is in the same slot of weights. Edges are stored in both directions, so walking a vertex's neighbours never needs
+//   a lookup to find a weight.
+class CSRGraph
+{
+public:
+    struct NeighbourRange
+    {
+        const vertIndex* first;
+        const vertIndex* last;
+
+        const vertIndex* begin() const { return first; }
+        const vertIndex* end() const { return last; }
+        size_t size() const { return last - first; }
+    };
+
+public:
+    pointList points;
+    std::vector<size_t> offsets;
+    std::vector<vertIndex> neighbours;
+    std::vector<edgeWeight> weights;
+    float minWeightPerDistance; // Lowest weight per unit of edge length, kept up to date by Build and SetWeights.
+
+    CSRGraph() : minWeightPerDistance( 0 ) {}
+
+    void Clear();
+    // Edges missing from the weight list get their length as a weight.
+    void Build(const pointList& points, const fullNeighbourList& neighbours, const fullEdgeList& weights);
+    void Build(const Graph& graph);
+    void SetWeights(const fullEdgeList& weights);
+    void ToGraph(Graph& graph) const;
+    fullNeighbourList ToNeighbourList() const;
+    fullEdgeList ToEdgeList() const;
+    bool PointHasNeighbour(vertIndex point, vertIndex neighbourToTestFor) const;
+
+    size_t GetVertexCount() const { return points.size(); }
+    NeighbourRange GetNeighbours(vertIndex point) const { return { neighbours.data() + offsets[point], neighbours.data() + offsets[point+1] }; }
+    edgeWeight GetWeight(vertIndex v1, vertIndex v2) const;
+
+    template<typename Func> void ForEachWeightedNeighbour(vertIndex point, Func func) const
+    {
+        for( size_t e=offsets[point]; e<offsets[point+1]; e++ )
+        {
+            func( neighbours[e], weights[e] );
+        }
+    }
 };
 
 class IndexGraph
@@ -39,32 +111,77 @@ float GetDifferenceBetweenAngles_Birectional(float angle1, float angle2);
 delaunator::Delaunator TriangulatePointList(const pointList& points);
 fullNeighbourList CreateNeighbourList(const pointList& points, float maxDistanceApart, float minInnerAngle);
 fullEdgeList CreateEdgeListWithWeights(const Graph& graph, bool randomWeights, int randomSeed, float fixedWeight);
+fullEdgeList CreateEdgeListWithWeights(const CSRGraph& graph, bool randomWeights, int randomSeed, float fixedWeight);
 fullEdgeList CreateEdgeListWithWeightsUsingVectorField(const Graph& graph, const std::vector<float>& rotations);
-fullEdgeList CreateEdgeListWithWeightsFromSourceImage(const Graph& graph, const cv::Mat& weightImage);
+fullEdgeList CreateEdgeListWithWeightsUsingVectorField(const CSRGraph& graph, const std::vector<float>& rotations);
+fullEdgeList CreateEdgeListWithWeightsFromSourceImage(const Graph& graph, const cv::Mat& weightImage, const PointDomain& domain = PointDomain());
+fullEdgeList CreateEdgeListWithWeightsFromSourceImage(const CSRGraph& graph, const cv::Mat& weightImage, const PointDomain& domain = PointDomain());
 
 graphPath FindShortestPath(const Graph& graph, vertIndex startIndex, vertIndex endIndex);
+graphPath FindShortestPath(const CSRGraph& graph, vertIndex startIndex, vertIndex endIndex);
 graphPath FindShortestPath_Dijkstra(const Graph& graph, vertIndex startIndex, vec2 endPosition);
+graphPath FindShortestPath_Dijkstra(const CSRGraph& graph, vertIndex startIndex, vec2 endPosition);
 graphPath FindShortestPath_Dijkstra(const Graph& graph, vertIndex startIndex, vertIndex endIndex);
+graphPath FindShortestPath_Dijkstra(const CSRGraph& graph, vertIndex startIndex, vertIndex endIndex);
+// The searches above reuse a thread-local SearchWorkspace, so they don't allocate once it's grown to fit the graph.
+// Pass a workspace to manage that memory directly, e.g. one per worker or per graph.
+graphPath FindShortestPath_Dijkstra(const Graph& graph, vertIndex startIndex, vertIndex endIndex, SearchWorkspace& workspace);
+graphPath FindShortestPath_Dijkstra(const CSRGraph& graph, vertIndex startIndex, vertIndex endIndex, SearchWorkspace& workspace);
+// A* with a straight line heuristic, distance to the goal times heuristicScale.
+// heuristicScale has to be at most the lowest weight per unit of edge length for the path to be the shortest one.
+// Graph callers pass it in, measure it once with GetMinimumWeightPerDistance and reuse it while the weights don't change.
+// CSRGraph keeps it up to date when built or given new weights, a negative value uses that.
+// Bidirectional searches from both ends at once, which usually expands fewer vertices on large graphs.
+float GetMinimumWeightPerDistance(const Graph& graph);
+float GetMinimumWeightPerDistance(const CSRGraph& graph);
+graphPath FindShortestPath_AStar(const Graph& graph, vertIndex startIndex, vec2 endPosition, bool bidirectional, float heuristicScale);
+graphPath FindShortestPath_AStar(const CSRGraph& graph, vertIndex startIndex, vec2 endPosition, bool bidirectional = false, float heuristicScale = -1.0f);
+graphPath FindShortestPath_AStar(const Graph& graph, vertIndex startIndex, vertIndex endIndex, bool bidirectional, float heuristicScale);
+graphPath FindShortestPath_AStar(const CSRGraph& graph, vertIndex startIndex, vertIndex endIndex, bool bidirectional = false, float heuristicScale = -1.0f);
 
 float DistanceFromLineSegment(vec2 start, vec2 end, vec2 point);
-linearWeightedEdgeList GenerateMinimumSpanningTree(const Graph& graph);
+linearWeightedEdgeList GenerateMinimumSpanningTree(const Graph& graph, MSTAlgorithm algorithm = MSTAlgorithm::Kruskal);
+linearWeightedEdgeList GenerateMinimumSpanningTree(const CSRGraph& graph, MSTAlgorithm algorithm = MSTAlgorithm::Kruskal);
 
 std::pair<int, float> FindNearestEdge(const pointList& points, const linearWeightedEdgeList& edgeList, vec2 point);
-std::pair<vertIndex, float> FindNearestPoint(pointList pointList, vec2 point);
+std::pair<vertIndex, float> FindNearestPoint(const pointList& points, vec2 point);
 
 void SplitGraph_BFSFloodFillOwnership(treeIndex owner, vertIndex startIndex, std::vector<VertexInfo>& vertexInfo, const fullNeighbourList& neighbours, const fullEdgeList& edgeList, const linearWeightedEdgeList& activeEdges);
 vertIndex FindNearestVertexToPoint(const pointList& points, vec2 point);
-linearWeightedEdgeList SplitGraph(std::vector<VertexInfo>& vertexInfo, const Graph& graph, const linearWeightedEdgeList& activeEdges, int numSplits, const pointList& treeRoots);
+linearWeightedEdgeList SplitGraph(std::vector<VertexInfo>& vertexInfo, const Graph& graph, const linearWeightedEdgeList& activeEdges, int numSplits, const pointList& treeRoots, RandomStream& stream);
+linearWeightedEdgeList SplitGraph(std::vector<VertexInfo>& vertexInfo, const CSRGraph& graph, const linearWeightedEdgeList& activeEdges, int numSplits, const pointList& treeRoots, RandomStream& stream);
 vertIndex FindNextNeighbourClockwiseFromIndex(const pointList& points, const pointIndexList& validVerts, const neighbourList& neighbours, vec2 pointPos, vec2 previousPos);
+vertIndex FindNextNeighbourClockwiseFromIndex(const pointList& points, const std::vector<bool>& isValidVert, const neighbourList& neighbours, vec2 pointPos, vec2 previousPos);
 pointIndexList BuildBoundaryVertexList(treeIndex treeLabel, const pointList& points, const fullNeighbourList& neighbours, const std::vector<VertexInfo>& vertexInfo);
 pointIndexList BuildBoundaryVertexList_Method2(treeIndex treeLabel, const pointList& points, const fullNeighbourList& neighbours, const std::vector<VertexInfo>& vertexInfo, const vertIndexList& vertsInRegion);
+
+// Boundaries for every region at once, from a label per vertex such as CreateLabelListFromOwners gives.
+// BuildBoundaryVertexLists returns the boundary verts for each label below numLabels, in one pass over the edges.
+// TraceRegionBoundaries walks the triangulation's half-edges to give each region's outline as ordered loops, following the
+//   triangulation's winding. A triangle belongs to a region when all 3 corners share its label, so regions with holes
+//   or separate parts give more than one loop.
+labelList CreateLabelListFromOwners(const std::vector<VertexInfo>& vertexInfo);
+std::vector<pointIndexList> BuildBoundaryVertexLists(const labelList& labels, const fullNeighbourList& neighbours, size_t numLabels);
+std::vector<std::pair<treeIndex, pointIndexList>> TraceRegionBoundaries(const delaunator::Delaunator& triangulation, const labelList& labels);
 vertIndex FindTopmostPointIndex(const pointList& points, const pointIndexList& allowedVerts);
 
 vertIndexList CreateGroupOfVertsNotBlockedByVertices(const Graph& graph, std::vector<VertexInfo>& vertexInfo, const vertIndexList& blockers, const vertIndex startIndex);
+vertIndexList CreateGroupOfVertsNotBlockedByVertices(const CSRGraph& graph, std::vector<VertexInfo>& vertexInfo, const vertIndexList& blockers, const vertIndex startIndex);
 vertIndexList CreateListOfVertsWithinStepsOfVertex(const Graph& graph, std::vector<VertexInfo>& vertexInfo, const vertIndex startIndex, float maxWeight);
+vertIndexList CreateListOfVertsWithinStepsOfVertex(const CSRGraph& graph, std::vector<VertexInfo>& vertexInfo, const vertIndex startIndex, float maxWeight);
+// The SearchWorkspace versions keep the search state in the workspace instead of vertexInfo, which is only read for owners.
+// The versions without one use a workspace kept for the calling thread, so they leave vertexInfo untouched too.
+// Reusing one workspace across many small searches avoids clearing state for every vertex in the graph each time.
+vertIndexList CreateGroupOfVertsNotBlockedByVertices(const Graph& graph, const std::vector<VertexInfo>& vertexInfo, SearchWorkspace& workspace, const vertIndexList& blockers, const vertIndex startIndex);
+vertIndexList CreateGroupOfVertsNotBlockedByVertices(const CSRGraph& graph, const std::vector<VertexInfo>& vertexInfo, SearchWorkspace& workspace, const vertIndexList& blockers, const vertIndex startIndex);
+vertIndexList CreateListOfVertsWithinStepsOfVertex(const Graph& graph, std::vector<VertexInfo>& vertexInfo, SearchWorkspace& workspace, const vertIndex startIndex, float maxWeight);
+vertIndexList CreateListOfVertsWithinStepsOfVertex(const CSRGraph& graph, std::vector<VertexInfo>& vertexInfo, SearchWorkspace& workspace, const vertIndex startIndex, float maxWeight);
 vertIndexList CreateListOfVertsWithinRadiusOfVertex(const Graph& graph, vertIndex center, float radius);
+vertIndexList CreateListOfVertsWithinRadiusOfVertex(const CSRGraph& graph, vertIndex center, float radius);
 
 void Graph_SwapIndex(std::vector<vec2>& pointList, fullNeighbourList& neighbours, vertIndex v1, vertIndex v2);
+void Graph_ApplyPermutation(std::vector<vec2>& pointList, fullNeighbourList& neighbours, const vertIndexList& newIndices);
 void Graph_RemovePoint(std::vector<vec2>& pointList, fullNeighbourList& neighbours, vertIndex indexToRemove);
+void Graph_RemovePoints(std::vector<vec2>& pointList, fullNeighbourList& neighbours, const vertIndexList& indicesToRemove);
 
 #endif __GraphHelpers_H__
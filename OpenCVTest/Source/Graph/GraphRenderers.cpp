@@ -3,8 +3,139 @@
 #include "GraphTypes.h"
 #include "GraphRenderers.h"
 
+void DrawPointSplats(cv::Mat& image, const std::vector<cv::Point>& centers, const std::vector<uint8>& styleIndices, const std::vector<SplatStyle>& styles)
+{
+    assert( image.type() == CV_8UC3 );
+    assert( centers.size() == styleIndices.size() );
+
+    const int tileHeight = 32;
+    int numTiles = (image.rows + tileHeight - 1) / tileHeight;
+
+    // Half width of each row of each disc, indexed by dy + radius.
+    // Rings also store the half width of the hole in each row, -1 for rows the hole doesn't reach.
+    std::vector<std::vector<int>> discSpans( styles.size() );
+    std::vector<std::vector<int>> holeSpans( styles.size() );
+    for( size_t s=0; s<styles.size(); s++ )
+    {
+        int radius = std::max( styles[s].radius, 0 );
+        float innerRadius = styles[s].innerRadius;
+        discSpans[s].resize( radius*2 + 1 );
+        holeSpans[s].resize( radius*2 + 1 );
+        for( int dy=-radius; dy<=radius; dy++ )
+        {
+            discSpans[s][dy + radius] = (int)( sqrtf( (float)(radius*radius - dy*dy) ) + 0.5f );
+
+            float holeSquared = innerRadius*innerRadius - dy*dy;
+            holeSpans[s][dy + radius] = holeSquared > 0 ? (int)floorf( sqrtf( holeSquared ) - 0.5f ) : -1;
+        }
+    }
+
+    // Returns false for discs that are completely off the image.
+    auto getRowRange = [&](size_t i, int* pFirstRow, int* pLastRow)
+    {
+        const cv::Point& center = centers[i];
+        int radius = std::max( styles[styleIndices[i]].radius, 0 );
+        if( center.x + radius < 0 || center.x - radius >= image.cols )
+            return false;
+
+        *pFirstRow = std::max( center.y - radius, 0 );
+        *pLastRow = std::min( center.y + radius, image.rows - 1 );
+        return *pFirstRow <= *pLastRow;
+    };
+
+    // Bin the points by row tile with a counting sort, keeping them in list order within each tile.
+    std::vector<uint32> tileStarts( numTiles + 1, 0 );
+    for( size_t i=0; i<centers.size(); i++ )
+    {
+        int firstRow, lastRow;
+        if( getRowRange( i, &firstRow, &lastRow ) == false )
+            continue;
+
+        for( int tile=firstRow/tileHeight; tile<=lastRow/tileHeight; tile++ )
+            tileStarts[tile+1]++;
+    }
+
+    for( int tile=0; tile<numTiles; tile++ )
+        tileStarts[tile+1] += tileStarts[tile];
+
+    std::vector<uint32> binnedPoints( tileStarts[numTiles] );
+    std::vector<uint32> tileFill( tileStarts.begin(), tileStarts.end() - 1 );
+    for( size_t i=0; i<centers.size(); i++ )
+    {
+        int firstRow, lastRow;
+        if( getRowRange( i, &firstRow, &lastRow ) == false )
+            continue;
+
+        for( int tile=firstRow/tileHeight; tile<=lastRow/tileHeight; tile++ )
+            binnedPoints[tileFill[tile]++] = (uint32)i;
+    }
+
+    // Each tile only writes its own rows.
+    cv::parallel_for_( cv::Range( 0, numTiles ), [&](const cv::Range& range)
+    {
+        for( int tile=range.start; tile<range.end; tile++ )
+        {
+            int tileFirstRow = tile * tileHeight;
+            int tileLastRow = std::min( tileFirstRow + tileHeight, image.rows ) - 1;
+
+            for( uint32 b=tileStarts[tile]; b<tileStarts[tile+1]; b++ )
+            {
+                uint32 i = binnedPoints[b];
+                const cv::Point& center = centers[i];
+                const SplatStyle& style = styles[styleIndices[i]];
+                const std::vector<int>& spans = discSpans[styleIndices[i]];
+                const std::vector<int>& holes = holeSpans[styleIndices[i]];
+                int radius = std::max( style.radius, 0 );
+
+                int firstRow = std::max( center.y - radius, tileFirstRow );
+                int lastRow = std::min( center.y + radius, tileLastRow );
+                for( int y=firstRow; y<=lastRow; y++ )
+                {
+                    int halfWidth = spans[y - center.y + radius];
+                    int holeHalfWidth = holes[y - center.y + radius];
+                    cv::Vec3b* row = image.ptr<cv::Vec3b>( y );
+
+                    // A filled row is one span, a row through a ring's hole is the two spans either side of it.
+                    int x0 = std::max( center.x - halfWidth, 0 );
+                    int x1 = std::min( center.x + halfWidth, image.cols - 1 );
+                    if( holeHalfWidth < 0 )
+                    {
+                        if( x0 <= x1 )
+                            std::fill( row + x0, row + x1 + 1, style.color );
+                        continue;
+                    }
+
+                    int leftEnd = std::min( center.x - holeHalfWidth - 1, x1 );
+                    if( x0 <= leftEnd )
+                        std::fill( row + x0, row + leftEnd + 1, style.color );
+
+                    int rightStart = std::max( center.x + holeHalfWidth + 1, x0 );
+                    if( rightStart <= x1 )
+                        std::fill( row + rightStart, row + x1 + 1, style.color );
+                }
+            }
+        }
+    } );
+}
+
 void DrawPointList(cv::Mat& image, vec2 imageScale, const pointList& points, cv::Vec3b color, int radius)
 {
+    // Large lists go through the batched rasterizer.
+    // cv::circle with a thickness of 'radius' draws a ring from 0.5 * radius out to 1.5 * radius, so the splats match that ring.
+    if( points.size() >= 1000 && image.type() == CV_8UC3 )
+    {
+        std::vector<cv::Point> centers( points.size() );
+        for( size_t i=0; i<points.size(); i++ )
+        {
+            centers[i] = cvPoint( points[i] * imageScale );
+        }
+
+        std::vector<uint8> styleIndices( points.size(), 0 );
+        std::vector<SplatStyle> styles = { { radius + radius/2, color, radius * 0.5f } };
+        DrawPointSplats( image, centers, styleIndices, styles );
+        return;
+    }
+
     for( size_t i=0; i<points.size(); i++ )
     {
         vec2 p1 = points[i] * imageScale;
@@ -30,7 +161,7 @@ void DrawTriangulation(cv::Mat& image, vec2 imageScale, const pointList& list, c
     }
 }
 
-void DrawPointsThatHaveNeighbours(cv::Mat& image, ivec2 imageSize, const std::vector<vec2>& pointList, const fullNeighbourList& neighbours)
+void DrawPointsThatHaveNeighbours(cv::Mat& image, ivec2 imageSize, const std::vector<vec2>& pointList, const fullNeighbourList& neighbours, const PointDomain& domain)
 {
     cv::Vec3b color = cv::Vec3b( 0, 255, 0 );
     int size = 8;
@@ -50,13 +181,13 @@ void DrawPointsThatHaveNeighbours(cv::Mat& image, ivec2 imageSize, const std::ve
             size = 4;
         }
 
-        vec2 pos = pointList[i] / 100.0f * vec2( (float)imageSize.x, (float)imageSize.y );
+        vec2 pos = domain.ToImage( pointList[i], imageSize );
 
         cv::circle( image, cv::Point((int)pos.x,(int)pos.y), size, color, -1 );
     }
 }
 
-void DrawPointsFlaggedInBoolVector(cv::Mat& image, ivec2 imageSize, const std::vector<vec2>& pointList, const std::vector<bool>& flaggedPoints)
+void DrawPointsFlaggedInBoolVector(cv::Mat& image, ivec2 imageSize, const std::vector<vec2>& pointList, const std::vector<bool>& flaggedPoints, const PointDomain& domain)
 {
     cv::Vec3b color = cv::Vec3b( 0, 255, 0 );
     int size = 1;
@@ -69,7 +200,7 @@ void DrawPointsFlaggedInBoolVector(cv::Mat& image, ivec2 imageSize, const std::v
     {
         if( flaggedPoints[i] )
         {
-            vec2 pos = pointList[i] / 100.0f * vec2( (float)imageSize.x, (float)imageSize.y );
+            vec2 pos = domain.ToImage( pointList[i], imageSize );
 
             cv::circle( image, cv::Point((int)pos.x,(int)pos.y), size, color, -1 );
         }
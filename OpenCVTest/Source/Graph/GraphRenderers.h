@@ -3,10 +3,21 @@
 
 #include "GraphTypes.h"
 
+// Filled discs or rings for large point counts, CV_8UC3 images only.
+// Points are binned into row tiles that are drawn in parallel, each tile draws its points in list order,
+//   so overlapping discs come out the same as drawing them one at a time.
+struct SplatStyle
+{
+    int radius;
+    cv::Vec3b color;
+    float innerRadius; // Pixels closer to the center than this are left alone, 0 for a filled disc.
+};
+void DrawPointSplats(cv::Mat& image, const std::vector<cv::Point>& centers, const std::vector<uint8>& styleIndices, const std::vector<SplatStyle>& styles);
+
 void DrawPointList(cv::Mat& image, vec2 imageScale, const pointList& points, cv::Vec3b color, int radius = 0);
 void DrawTriangulation(cv::Mat& image, vec2 imageScale, const pointList& list, const fullNeighbourList& neighbours, cv::Scalar lineColor);
-void DrawPointsThatHaveNeighbours(cv::Mat& image, ivec2 imageSize, const std::vector<vec2>& pointList, const fullNeighbourList& neighbours);
-void DrawPointsFlaggedInBoolVector(cv::Mat& image, ivec2 imageSize, const std::vector<vec2>& pointList, const std::vector<bool>& flaggedPoints);
+void DrawPointsThatHaveNeighbours(cv::Mat& image, ivec2 imageSize, const std::vector<vec2>& pointList, const fullNeighbourList& neighbours, const PointDomain& domain = PointDomain());
+void DrawPointsFlaggedInBoolVector(cv::Mat& image, ivec2 imageSize, const std::vector<vec2>& pointList, const std::vector<bool>& flaggedPoints, const PointDomain& domain = PointDomain());
 void DrawPath(cv::Mat& image, vec2 imageScale, const pointList& points, const graphPath& path, cv::Scalar lineColor);
 
 #endif __GraphRenderers_H__
@@ -31,6 +31,37 @@ typedef std::map<vertIndex, edgeWeight> vertEdgeList;
 typedef std::map<vertIndex, vertEdgeList> fullEdgeList; // Edges only stored in lower vertIndex list.
 typedef std::vector<std::tuple<vertIndex, vertIndex, vertIndex>> triIndexList;
 
+// The rectangle a point set lives in. Distances and positions are in the domain's own units,
+//   so a 50km map sampled every meter is a 50000x50000 domain with a distance of 1.
+// The default is the 0 to 100 space everything originally assumed.
+struct PointDomain
+{
+    vec2 origin;
+    vec2 size;
+
+    PointDomain() : origin( 0, 0 ), size( 100, 100 ) {}
+    PointDomain(vec2 origin, vec2 size) : origin( origin ), size( size ) {}
+
+    vec2 GetMax() const { return vec2( origin.x + size.x, origin.y + size.y ); }
+
+    bool Contains(vec2 pos) const
+    {
+        return pos.x >= origin.x && pos.x < origin.x + size.x &&
+               pos.y >= origin.y && pos.y < origin.y + size.y;
+    }
+
+    // 0 to 1 across the domain.
+    vec2 ToNormalized(vec2 pos) const { return vec2( (pos.x - origin.x) / size.x, (pos.y - origin.y) / size.y ); }
+    vec2 FromNormalized(vec2 pos) const { return vec2( origin.x + pos.x * size.x, origin.y + pos.y * size.y ); }
+
+    // Position in an image that covers the whole domain.
+    vec2 ToImage(vec2 pos, ivec2 imageSize) const
+    {
+        vec2 normalized = ToNormalized( pos );
+        return vec2( normalized.x * imageSize.x, normalized.y * imageSize.y );
+    }
+};
+
 // VertexInfo is used by Dijkstra pathfinder and SplitGraph routines.
 class VertexInfo
 {
@@ -0,0 +1,139 @@
+#ifndef __PriorityQueue_H__
+#define __PriorityQueue_H__
+
+#include "Graph/GraphTypes.h"
+
+// Indexed 4-ary min heap, used as the open list for Dijkstra style searches.
+// Items are vertex indices below the count given to Reset and each one can only be in the heap once,
+//   lowering the key of an item already in the heap moves it up in place instead of adding a second copy.
+// 4 children per node keeps the tree shallow and the children of a node next to each other in memory,
+//   which suits searches that do a lot more key decreases than pops.
+class IndexedPriorityQueue
+{
+protected:
+    struct Entry
+    {
+        edgeWeight key;
+        vertIndex item;
+    };
+
+    static constexpr size_t NotInHeap = (size_t)-1;
+
+    std::vector<Entry> m_Heap;
+    std::vector<size_t> m_Positions; // Slot in m_Heap for each item, NotInHeap if it isn't in the heap.
+
+public:
+    // Only the items still in the heap need clearing, so reusing a queue doesn't cost a pass over every item.
+    void Reset(size_t numItems)
+    {
+        for( const Entry& entry : m_Heap )
+        {
+            m_Positions[entry.item] = NotInHeap;
+        }
+        m_Heap.clear();
+
+        if( m_Positions.size() < numItems )
+        {
+            m_Positions.resize( numItems, NotInHeap );
+        }
+    }
+
+    bool IsEmpty() const { return m_Heap.empty(); }
+    size_t Size() const { return m_Heap.size(); }
+    bool Contains(vertIndex item) const { return m_Positions[item] != NotInHeap; }
+    edgeWeight GetMinKey() const { return m_Heap[0].key; }
+    vertIndex GetMinItem() const { return m_Heap[0].item; }
+
+    // Adds the item, or lowers its key if it's already in the heap. Higher keys for items already in the heap are ignored.
+    void PushOrDecrease(vertIndex item, edgeWeight key)
+    {
+        size_t slot = m_Positions[item];
+        if( slot == NotInHeap )
+        {
+            slot = m_Heap.size();
+            m_Heap.push_back( { key, item } );
+            m_Positions[item] = slot;
+        }
+        else if( key < m_Heap[slot].key )
+        {
+            m_Heap[slot].key = key;
+        }
+        else
+        {
+            return;
+        }
+
+        SiftUp( slot );
+    }
+
+    vertIndex PopMin()
+    {
+        assert( m_Heap.empty() == false );
+
+        vertIndex item = m_Heap[0].item;
+        m_Positions[item] = NotInHeap;
+
+        Entry last = m_Heap.back();
+        m_Heap.pop_back();
+        if( m_Heap.empty() == false )
+        {
+            m_Heap[0] = last;
+            m_Positions[last.item] = 0;
+            SiftDown( 0 );
+        }
+
+        return item;
+    }
+
+protected:
+    void SiftUp(size_t slot)
+    {
+        Entry entry = m_Heap[slot];
+        while( slot > 0 )
+        {
+            size_t parent = (slot - 1) / 4;
+            if( m_Heap[parent].key <= entry.key )
+                break;
+
+            m_Heap[slot] = m_Heap[parent];
+            m_Positions[m_Heap[slot].item] = slot;
+            slot = parent;
+        }
+
+        m_Heap[slot] = entry;
+        m_Positions[entry.item] = slot;
+    }
+
+    void SiftDown(size_t slot)
+    {
+        Entry entry = m_Heap[slot];
+        size_t count = m_Heap.size();
+        while( true )
+        {
+            size_t firstChild = slot*4 + 1;
+            if( firstChild >= count )
+                break;
+
+            // Find the smallest of up to 4 children.
+            size_t smallest = firstChild;
+            size_t lastChild = std::min( firstChild + 4, count );
+            for( size_t child=firstChild+1; child<lastChild; child++ )
+            {
+                if( m_Heap[child].key < m_Heap[smallest].key )
+                    smallest = child;
+            }
+
+            if( entry.key <= m_Heap[smallest].key )
+                break;
+
+            m_Heap[slot] = m_Heap[smallest];
+            m_Positions[m_Heap[slot].item] = slot;
+            slot = smallest;
+        }
+
+        m_Heap[slot] = entry;
+        m_Positions[entry.item] = slot;
+    }
+};
+
+#endif //__PriorityQueue_H__
@@ -0,0 +1,108 @@
+#ifndef __SearchWorkspace_H__
+#define __SearchWorkspace_H__
+
+#include "Graph/GraphTypes.h"
+#include "Graph/PriorityQueue.h"
+
+// Per-vertex search state kept in separate arrays, so a search only pulls in the values it reads.
+// Each search starts a new generation instead of clearing the arrays. Entries stamped with an older generation read as
+//   unvisited, so starting a search doesn't depend on the size of the graph and only the vertices a search reaches get written.
+// A workspace can be reused for any number of searches, on any graph, but only by one search at a time.
+class SearchWorkspace
+{
+protected:
+    uint32 m_Generation;
+    std::vector<uint32> m_Stamps;       // Generation each vertex's distance, parent and owner were last set in.
+    std::vector<uint32> m_ClosedStamps; // Generation each vertex was last closed in.
+    std::vector<edgeWeight> m_Distances;
+    std::vector<vertIndex> m_Parents;
+    std::vector<treeIndex> m_Owners;
+
+    IndexedPriorityQueue m_OpenList;
+
+protected:
+    void Touch(vertIndex v)
+    {
+        if( m_Stamps[v] != m_Generation )
+        {
+            m_Stamps[v] = m_Generation;
+            m_Distances[v] = FLT_MAX;
+            m_Parents[v] = -1;
+            m_Owners[v] = 0;
+        }
+    }
+
+public:
+    SearchWorkspace() : m_Generation( 0 ) {}
+
+    // Workspaces kept for the life of each thread, so repeated queries don't allocate once the arrays are big enough.
+    // The same slot can't be used by two searches at once, so a search that needs more than one workspace, or that
+    //   runs inside another pooled search, has to use a different slot.
+    // Slots 0 and 1 are for searches that don't call out to other code. The DijkstraSearchObject based helpers use
+    //   LocalSearchSlot, since their callbacks are free to run searches of their own.
+    static const int LocalSearchSlot = 2;
+    static const int NumThreadLocalSlots = 3;
+    static SearchWorkspace& GetThreadLocal(int slot = 0)
+    {
+        assert( slot >= 0 && slot < NumThreadLocalSlots );
+
+        thread_local SearchWorkspace workspaces[NumThreadLocalSlots];
+        return workspaces[slot];
+    }
+
+    // Starts a new search on a graph with numVerts vertices, everything reads as unvisited afterwards.
+    void BeginSearch(size_t numVerts)
+    {
+        if( m_Stamps.size() < numVerts )
+        {
+            m_Stamps.resize( numVerts, 0 );
+            m_ClosedStamps.resize( numVerts, 0 );
+            m_Distances.resize( numVerts );
+            m_Parents.resize( numVerts );
+            m_Owners.resize( numVerts );
+        }
+
+        m_Generation++;
+
+        // After wrapping around, stamps from long ago could look current again.
+        if( m_Generation == 0 )
+        {
+            std::fill( m_Stamps.begin(), m_Stamps.end(), 0 );
+            std::fill( m_ClosedStamps.begin(), m_ClosedStamps.end(), 0 );
+            m_Generation = 1;
+        }
+
+        m_OpenList.Reset( numVerts );
+    }
+
+    size_t GetSize() const { return m_Stamps.size(); }
+    IndexedPriorityQueue& GetOpenList() { return m_OpenList; }
+
+    bool IsReached(vertIndex v) const { return m_Stamps[v] == m_Generation; }
+    bool IsClosed(vertIndex v) const { return m_ClosedStamps[v] == m_Generation; }
+    edgeWeight GetDistance(vertIndex v) const { return IsReached( v ) ? m_Distances[v] : FLT_MAX; }
+    vertIndex GetParent(vertIndex v) const { return IsReached( v ) ? m_Parents[v] : -1; }
+    treeIndex GetOwner(vertIndex v) const { return IsReached( v ) ? m_Owners[v] : 0; }
+
+    void SetClosed(vertIndex v) { m_ClosedStamps[v] = m_Generation; }
+    void SetDistance(vertIndex v, edgeWeight distance) { Touch( v ); m_Distances[v] = distance; }
+    void SetParent(vertIndex v, vertIndex parent) { Touch( v ); m_Parents[v] = parent; }
+    void SetOwner(vertIndex v, treeIndex owner) { Touch( v ); m_Owners[v] = owner; }
+
+    // Walks parents back from endIndex, so the path goes from the end to the start.
+    graphPath BuildPath(vertIndex endIndex) const
+    {
+        graphPath path;
+
+        vertIndex i = endIndex;
+        while( i != -1 )
+        {
+            path.push_back( i );
+            i = GetParent( i );
+        }
+
+        return path;
+    }
+};
+
+#endif //__SearchWorkspace_H__
@@ -0,0 +1,578 @@
+#include "OpenCVPCH.h"
+
+#include "SpatialIndex.h"
+#include "GraphHelpers.h"
+
+SpatialIndex::SpatialIndex()
+{
+    Clear();
+}
+
+void SpatialIndex::Clear()
+{
+    m_Points.clear();
+    m_Edges.clear();
+    m_EdgesOfPoint.clear();
+
+    m_Min = vec2( 0, 0 );
+    m_CellSize = 1;
+    m_RequestedCellSize = 0;
+    m_GridSize = ivec2( 1, 1 );
+
+    m_PointCells.assign( 1, vertIndexList() );
+    m_EdgeCells.assign( 1, std::vector<int>() );
+}
+
+void SpatialIndex::Build(const pointList& points, float cellSize)
+{
+    m_Points = points;
+    m_Edges.clear();
+    m_EdgesOfPoint.clear();
+
+    m_RequestedCellSize = cellSize;
+    RebuildGrid( cellSize, false );
+}
+
+void SpatialIndex::Build(const pointList& points, const linearWeightedEdgeList& edges, float cellSize)
+{
+    Build( points, cellSize );
+    SetEdges( edges );
+}
+
+void SpatialIndex::SetEdges(const linearWeightedEdgeList& edges)
+{
+    m_Edges.clear();
+    m_EdgesOfPoint.assign( m_Points.size(), std::vector<int>() );
+    m_EdgeCells.assign( m_PointCells.size(), std::vector<int>() );
+
+    for( size_t i=0; i<edges.size(); i++ )
+    {
+        vertIndex v1 = std::get<EdgeIndex1>( edges[i] );
+        vertIndex v2 = std::get<EdgeIndex2>( edges[i] );
+
+        m_Edges.push_back( { v1, v2 } );
+        m_EdgesOfPoint[v1].push_back( (int)i );
+        m_EdgesOfPoint[v2].push_back( (int)i );
+        AddEdgeToCells( (int)i );
+    }
+}
+
+void SpatialIndex::RebuildGrid(float cellSize, bool padBounds)
+{
+    vec2 min( 0, 0 );
+    vec2 max( 0, 0 );
+    if( m_Points.size() > 0 )
+    {
+        min = max = m_Points[0];
+        for( const vec2& pos : m_Points )
+        {
+            min.x = std::min( min.x, pos.x );
+            min.y = std::min( min.y, pos.y );
+            max.x = std::max( max.x, pos.x );
+            max.y = std::max( max.y, pos.y );
+        }
+    }
+
+    vec2 size = max - min;
+    size_t numPoints = std::max( m_Points.size(), (size_t)1 );
+
+    // Aim for about 2 points per cell.
+    if( cellSize <= 0 )
+    {
+        float area = size.x * size.y;
+        if( area > 0 )
+            cellSize = sqrtf( area * 2 / numPoints );
+        else
+            cellSize = std::max( size.x, size.y ) * 2 / numPoints;
+
+        if( cellSize <= 0 )
+            cellSize = 1;
+    }
+
+    // Leave room around the points so points added or moved outward land in the grid for a while,
+    //   a point outside the padding grows the bounds by at least half, so points spreading outward only rebuild now and then.
+    if( padBounds )
+    {
+        float padding = std::max( std::max( size.x, size.y ) * 0.5f, cellSize );
+        min = min - vec2( padding, padding );
+        size = size + vec2( padding*2, padding*2 );
+    }
+
+    // Don't let a small requested cell size make a grid with far more cells than points.
+    double maxCells = 4.0 * numPoints + 64;
+    double numCells = ((double)size.x / cellSize + 1) * ((double)size.y / cellSize + 1);
+    if( numCells > maxCells )
+    {
+        cellSize *= (float)sqrt( numCells / maxCells );
+    }
+
+    m_Min = min;
+    m_CellSize = cellSize;
+    m_GridSize.x = (int)(size.x / cellSize) + 1;
+    m_GridSize.y = (int)(size.y / cellSize) + 1;
+
+    m_PointCells.assign( m_GridSize.x * m_GridSize.y, vertIndexList() );
+    m_EdgeCells.assign( m_GridSize.x * m_GridSize.y, std::vector<int>() );
+
+    for( vertIndex i=0; i<m_Points.size(); i++ )
+    {
+        AddPointToCell( i );
+    }
+
+    for( size_t i=0; i<m_Edges.size(); i++ )
+    {
+        AddEdgeToCells( (int)i );
+    }
+}
+
+ivec2 SpatialIndex::GetCell(vec2 pos) const
+{
+    int x = (int)floorf( (pos.x - m_Min.x) / m_CellSize );
+    int y = (int)floorf( (pos.y - m_Min.y) / m_CellSize );
+
+    x = std::min( std::max( x, 0 ), m_GridSize.x-1 );
+    y = std::min( std::max( y, 0 ), m_GridSize.y-1 );
+
+    return ivec2( x, y );
+}
+
+bool SpatialIndex::IsInsideGrid(vec2 pos) const
+{
+    return pos.x >= m_Min.x && pos.x < m_Min.x + m_GridSize.x * m_CellSize &&
+           pos.y >= m_Min.y && pos.y < m_Min.y + m_GridSize.y * m_CellSize;
+}
+
+void SpatialIndex::AddPointToCell(vertIndex index)
+{
+    m_PointCells[GetCellIndex( GetCell( m_Points[index] ) )].push_back( index );
+}
+
+void SpatialIndex::RemovePointFromCell(vertIndex index)
+{
+    vertIndexList& cell = m_PointCells[GetCellIndex( GetCell( m_Points[index] ) )];
+
+    auto it = std::find( cell.begin(), cell.end(), index );
+    if( it != cell.end() )
+    {
+        *it = cell.back();
+        cell.pop_back();
+    }
+}
+
+void SpatialIndex::GetEdgeCellRange(int edgeIndex, ivec2* pMinCell, ivec2* pMaxCell) const
+{
+    ivec2 cell1 = GetCell( m_Points[m_Edges[edgeIndex].first] );
+    ivec2 cell2 = GetCell( m_Points[m_Edges[edgeIndex].second] );
+
+    *pMinCell = ivec2( std::min( cell1.x, cell2.x ), std::min( cell1.y, cell2.y ) );
+    *pMaxCell = ivec2( std::max( cell1.x, cell2.x ), std::max( cell1.y, cell2.y ) );
+}
+
+void SpatialIndex::AddEdgeToCells(int edgeIndex)
+{
+    ivec2 minCell, maxCell;
+    GetEdgeCellRange( edgeIndex, &minCell, &maxCell );
+
+    for( int y=minCell.y; y<=maxCell.y; y++ )
+    {
+        for( int x=minCell.x; x<=maxCell.x; x++ )
+        {
+            m_EdgeCells[GetCellIndex( ivec2( x, y ) )].push_back( edgeIndex );
+        }
+    }
+}
+
+void SpatialIndex::RemoveEdgeFromCells(int edgeIndex)
+{
+    ivec2 minCell, maxCell;
+    GetEdgeCellRange( edgeIndex, &minCell, &maxCell );
+
+    for( int y=minCell.y; y<=maxCell.y; y++ )
+    {
+        for( int x=minCell.x; x<=maxCell.x; x++ )
+        {
+            std::vector<int>& cell = m_EdgeCells[GetCellIndex( ivec2( x, y ) )];
+
+            auto it = std::find( cell.begin(), cell.end(), edgeIndex );
+            if( it != cell.end() )
+            {
+                *it = cell.back();
+                cell.pop_back();
+            }
+        }
+    }
+}
+
+vertIndex SpatialIndex::AddPoint(vec2 pos)
+{
+    vertIndex index = m_Points.size();
+    m_Points.push_back( pos );
+
+    if( m_Edges.size() > 0 )
+    {
+        m_EdgesOfPoint.push_back( std::vector<int>() );
+    }
+
+    if( IsInsideGrid( pos ) )
+    {
+        AddPointToCell( index );
+    }
+    else
+    {
+        RebuildGrid( m_RequestedCellSize, true );
+    }
+
+    return index;
+}
+
+void SpatialIndex::MovePoint(vertIndex index, vec2 pos)
+{
+    if( IsInsideGrid( pos ) == false )
+    {
+        m_Points[index] = pos;
+        RebuildGrid( m_RequestedCellSize, true );
+        return;
+    }
+
+    // Take the point and its edges out of the cells for the old position, then add them back at the new one.
+    RemovePointFromCell( index );
+    if( m_Edges.size() > 0 )
+    {
+        for( int edgeIndex : m_EdgesOfPoint[index] )
+        {
+            RemoveEdgeFromCells( edgeIndex );
+        }
+    }
+
+    m_Points[index] = pos;
+
+    AddPointToCell( index );
+    if( m_Edges.size() > 0 )
+    {
+        for( int edgeIndex : m_EdgesOfPoint[index] )
+        {
+            AddEdgeToCells( edgeIndex );
+        }
+    }
+}
+
+template<typename Func> void SpatialIndex::ForEachCellInRing(ivec2 center, int ring, Func func) const
+{
+    if( ring == 0 )
+    {
+        func( GetCellIndex( center ) );
+        return;
+    }
+
+    int minX = std::max( center.x - ring, 0 );
+    int maxX = std::min( center.x + ring, m_GridSize.x-1 );
+    int minY = std::max( center.y - ring + 1, 0 );
+    int maxY = std::min( center.y + ring - 1, m_GridSize.y-1 );
+
+    // Top and bottom rows.
+    for( int y : { center.y - ring, center.y + ring } )
+    {
+        if( y < 0 || y >= m_GridSize.y )
+            continue;
+
+        for( int x=minX; x<=maxX; x++ )
+        {
+            func( GetCellIndex( ivec2( x, y ) ) );
+        }
+    }
+
+    // Left and right columns, without the corners.
+    for( int x : { center.x - ring, center.x + ring } )
+    {
+        if( x < 0 || x >= m_GridSize.x )
+            continue;
+
+        for( int y=minY; y<=maxY; y++ )
+        {
+            func( GetCellIndex( ivec2( x, y ) ) );
+        }
+    }
+}
+
+float SpatialIndex::GetRingLowerBound(vec2 pos, ivec2 center, int ring) const
+{
+    // Anything in an unvisited cell is at least 'ring' cells from the center cell,
+    //   take off however far pos is from the center cell in case it's outside the grid.
+    vec2 cellMin = m_Min + vec2( center.x * m_CellSize, center.y * m_CellSize );
+    vec2 cellMax = cellMin + vec2( m_CellSize, m_CellSize );
+
+    float dx = std::max( std::max( cellMin.x - pos.x, pos.x - cellMax.x ), 0.0f );
+    float dy = std::max( std::max( cellMin.y - pos.y, pos.y - cellMax.y ), 0.0f );
+
+    return ring * m_CellSize - sqrtf( dx*dx + dy*dy );
+}
+
+int SpatialIndex::GetMaxRing(ivec2 center) const
+{
+    return std::max( std::max( center.x, m_GridSize.x-1 - center.x ), std::max( center.y, m_GridSize.y-1 - center.y ) );
+}
+
+std::pair<vertIndex, float> SpatialIndex::FindNearestPoint(vec2 pos) const
+{
+    vertIndex closestPointIndex = -1;
+    float closestDist = FLT_MAX;
+
+    if( m_Points.size() == 0 )
+        return { closestPointIndex, closestDist };
+
+    ivec2 center = GetCell( pos );
+    int maxRing = GetMaxRing( center );
+
+    for( int ring=0; ring<=maxRing; ring++ )
+    {
+        ForEachCellInRing( center, ring, [&](int cellIndex)
+        {
+            for( const vertIndex i : m_PointCells[cellIndex] )
+            {
+                // Ties go to the lowest index, same as a linear scan.
+                float dist = m_Points[i].DistanceFrom( pos );
+                if( dist < closestDist || (dist == closestDist && i < closestPointIndex) )
+                {
+                    closestDist = dist;
+                    closestPointIndex = i;
+                }
+            }
+        } );
+
+        if( closestDist < GetRingLowerBound( pos, center, ring ) )
+            break;
+    }
+
+    return { closestPointIndex, closestDist };
+}
+
+std::pair<int, float> SpatialIndex::FindNearestEdge(vec2 pos) const
+{
+    int closestEdgeIndex = -1;
+    float closestDist = FLT_MAX;
+
+    if( m_Edges.size() == 0 )
+        return { closestEdgeIndex, closestDist };
+
+    ivec2 center = GetCell( pos );
+    int maxRing = GetMaxRing( center );
+
+    for( int ring=0; ring<=maxRing; ring++ )
+    {
+        ForEachCellInRing( center, ring, [&](int cellIndex)
+        {
+            // Long edges are in several cells and can be tested more than once, which doesn't change the result.
+            for( const int i : m_EdgeCells[cellIndex] )
+            {
+                float dist = DistanceFromLineSegment( m_Points[m_Edges[i].first], m_Points[m_Edges[i].second], pos );
+                if( dist < closestDist || (dist == closestDist && i < closestEdgeIndex) )
+                {
+                    closestDist = dist;
+                    closestEdgeIndex = i;
+                }
+            }
+        } );
+
+        if( closestDist < GetRingLowerBound( pos, center, ring ) )
+            break;
+    }
+
+    return { closestEdgeIndex, closestDist };
+}
+
+vertIndexList SpatialIndex::FindNearestPoints(vec2 pos, size_t count) const
+{
+    vertIndexList result;
+
+    if( m_Points.size() == 0 || count == 0 )
+        return result;
+
+    // Max heap of the closest points found so far, the furthest one is on top.
+    std::priority_queue<std::pair<float, vertIndex>> closest;
+
+    ivec2 center = GetCell( pos );
+    int maxRing = GetMaxRing( center );
+
+    for( int ring=0; ring<=maxRing; ring++ )
+    {
+        ForEachCellInRing( center, ring, [&](int cellIndex)
+        {
+            for( const vertIndex i : m_PointCells[cellIndex] )
+            {
+                std::pair<float, vertIndex> candidate( m_Points[i].DistanceFrom( pos ), i );
+                if( closest.size() < count )
+                {
+                    closest.push( candidate );
+                }
+                else if( candidate < closest.top() )
+                {
+                    closest.pop();
+                    closest.push( candidate );
+                }
+            }
+        } );
+
+        if( closest.size() == count && closest.top().first < GetRingLowerBound( pos, center, ring ) )
+            break;
+    }
+
+    result.resize( closest.size() );
+    for( size_t i=result.size(); i>0; i-- )
+    {
+        result[i-1] = closest.top().second;
+        closest.pop();
+    }
+
+    return result;
+}
+
+vertIndexList SpatialIndex::FindPointsWithinRadius(vec2 pos, float radius) const
+{
+    vertIndexList verts;
+
+    if( m_Points.size() == 0 )
+        return verts;
+
+    float radiusSquared = radius*radius;
+
+    ivec2 minCell = GetCell( pos - vec2( radius, radius ) );
+    ivec2 maxCell = GetCell( pos + vec2( radius, radius ) );
+
+    for( int y=minCell.y; y<=maxCell.y; y++ )
+    {
+        for( int x=minCell.x; x<=maxCell.x; x++ )
+        {
+            for( const vertIndex i : m_PointCells[GetCellIndex( ivec2( x, y ) )] )
+            {
+                float distSquared = (m_Points[i] - pos).LengthSquared();
+                if( distSquared < radiusSquared )
+                {
+                    verts.push_back( i );
+                }
+            }
+        }
+    }
+
+    return verts;
+}
+
+// Spreads the low 16 bits out to every other bit, so two of them can be interleaved into a Morton code.
+static uint32 SpreadBits16(uint32 value)
+{
+    value &= 0xFFFF;
+    value = (value | (value << 8)) & 0x00FF00FF;
+    value = (value | (value << 4)) & 0x0F0F0F0F;
+    value = (value | (value << 2)) & 0x33333333;
+    value = (value | (value << 1)) & 0x55555555;
+    return value;
+}
+
+vertIndexList SpatialIndex::FindNearestPointForEach(const pointList& positions, bool sortByMortonOrder) const
+{
+    vertIndexList results( positions.size(), -1 );
+
+    if( positions.size() == 0 || m_Points.size() == 0 )
+        return results;
+
+    // Order to run the queries in.
+    std::vector<size_t> order( positions.size() );
+    for( size_t i=0; i<order.size(); i++ )
+    {
+        order[i] = i;
+    }
+
+    if( sortByMortonOrder )
+    {
+        std::vector<uint32> codes( positions.size() );
+        for( size_t i=0; i<positions.size(); i++ )
+        {
+            ivec2 cell = GetCell( positions[i] );
+            codes[i] = SpreadBits16( cell.x ) | (SpreadBits16( cell.y ) << 1);
+        }
+
+        std::sort( order.begin(), order.end(), [&](size_t a, size_t b)
+        {
+            return codes[a] < codes[b] || (codes[a] == codes[b] && a < b);
+        } );
+    }
+
+    const int blockSize = 256;
+    int numBlocks = (int)((positions.size() + blockSize - 1) / blockSize);
+
+    cv::parallel_for_( cv::Range( 0, numBlocks ), [&](const cv::Range& range)
+    {
+        for( int b=range.start; b<range.end; b++ )
+        {
+            size_t end = std::min( positions.size(), (size_t)(b+1) * blockSize );
+            for( size_t i=(size_t)b * blockSize; i<end; i++ )
+            {
+                size_t queryIndex = order[i];
+                results[queryIndex] = FindNearestPoint( positions[queryIndex] ).first;
+            }
+        }
+    } );
+
+    return results;
+}
+
+void SpatialIndex::LabelImageByNearestPoint(cv::Mat& labelImage, ivec2 imageSize, const PointDomain& domain) const
+{
+    labelImage.create( imageSize.y, imageSize.x, CV_32SC1 );
+
+    if( m_Points.size() == 0 )
+    {
+        labelImage.setTo( -1 );
+        return;
+    }
+
+    // Pixels are done in square tiles. The nearest point to any pixel in a tile is no further from the tile's center than
+    //   the center's own nearest point plus the tile's diagonal, so each tile only tests the points inside that radius.
+    const int tileSize = 8;
+    int tilesX = (imageSize.x + tileSize - 1) / tileSize;
+    int tilesY = (imageSize.y + tileSize - 1) / tileSize;
+
+    vec2 pixelSize( domain.size.x / imageSize.x, domain.size.y / imageSize.y );
+
+    cv::parallel_for_( cv::Range( 0, tilesX * tilesY ), [&](const cv::Range& range)
+    {
+        for( int t=range.start; t<range.end; t++ )
+        {
+            int startX = (t % tilesX) * tileSize;
+            int startY = (t / tilesX) * tileSize;
+            int endX = std::min( startX + tileSize, imageSize.x );
+            int endY = std::min( startY + tileSize, imageSize.y );
+
+            vec2 tileMin = domain.origin + vec2( startX * pixelSize.x, startY * pixelSize.y );
+            vec2 tileMax = domain.origin + vec2( endX * pixelSize.x, endY * pixelSize.y );
+            vec2 tileCenter = (tileMin + tileMax) * 0.5f;
+            float halfDiagonal = (tileMax - tileMin).Length() * 0.5f;
+
+            float centerDist = FindNearestPoint( tileCenter ).second;
+            float searchRadius = (centerDist + halfDiagonal*2) * 1.001f + 0.001f;
+            vertIndexList candidates = FindPointsWithinRadius( tileCenter, searchRadius );
+
+            for( int y=startY; y<endY; y++ )
+            {
+                int* pRow = labelImage.ptr<int>( y );
+                for( int x=startX; x<endX; x++ )
+                {
+                    vec2 pos = domain.origin + vec2( (x + 0.5f) * pixelSize.x, (y + 0.5f) * pixelSize.y );
+
+                    vertIndex closestIndex = -1;
+                    float closestDist = FLT_MAX;
+                    for( const vertIndex i : candidates )
+                    {
+                        float dist = m_Points[i].DistanceFrom( pos );
+                        if( dist < closestDist || (dist == closestDist && i < closestIndex) )
+                        {
+                            closestDist = dist;
+                            closestIndex = i;
+                        }
+                    }
+
+                    pRow[x] = (int)closestIndex;
+                }
+            }
+        }
+    } );
+}
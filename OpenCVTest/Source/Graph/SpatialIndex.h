@@ -0,0 +1,81 @@
+#ifndef __SpatialIndex_H__
+#define __SpatialIndex_H__
+
+#include "Graph/GraphTypes.h"
+
+// Uniform grid over a point list, and optionally the edges between those points.
+// Cells are sized for about 2 points each, so nearest, k nearest and radius queries only look at a handful of cells
+//   instead of every point. Edges are stored in every cell their bounding box touches.
+// The index keeps its own copy of the point positions, points can be added or moved without a full rebuild as long as
+//   they stay inside the grid, anything outside grows the grid with room to spare and rebuilds it.
+// Queries are const and don't change any state, so they can be run from several threads at once.
+class SpatialIndex
+{
+protected:
+    pointList m_Points;
+    std::vector<std::pair<vertIndex, vertIndex>> m_Edges;
+    std::vector<std::vector<int>> m_EdgesOfPoint; // Only filled in when edges are used.
+
+    vec2 m_Min;
+    float m_CellSize;
+    float m_RequestedCellSize; // Cell size passed to Build, 0 to pick one, kept when the grid grows.
+    ivec2 m_GridSize;
+
+    std::vector<vertIndexList> m_PointCells;
+    std::vector<std::vector<int>> m_EdgeCells;
+
+protected:
+    // padBounds leaves space around the points, for rebuilds caused by a point landing outside the grid.
+    void RebuildGrid(float cellSize, bool padBounds);
+
+    ivec2 GetCell(vec2 pos) const;
+    int GetCellIndex(ivec2 cell) const { return cell.y * m_GridSize.x + cell.x; }
+    bool IsInsideGrid(vec2 pos) const;
+
+    void AddPointToCell(vertIndex index);
+    void RemovePointFromCell(vertIndex index);
+    void AddEdgeToCells(int edgeIndex);
+    void RemoveEdgeFromCells(int edgeIndex);
+    void GetEdgeCellRange(int edgeIndex, ivec2* pMinCell, ivec2* pMaxCell) const;
+
+    // Calls func(cellIndex) for every cell 'ring' cells away from 'center', ring 0 is the center cell itself.
+    template<typename Func> void ForEachCellInRing(ivec2 center, int ring, Func func) const;
+    // No point or edge outside rings 0 to 'ring' can be closer to pos than this.
+    float GetRingLowerBound(vec2 pos, ivec2 center, int ring) const;
+    int GetMaxRing(ivec2 center) const;
+
+public:
+    SpatialIndex();
+
+    void Clear();
+
+    // A cell size of 0 picks one based on the bounds and number of points.
+    void Build(const pointList& points, float cellSize = 0);
+    void Build(const pointList& points, const linearWeightedEdgeList& edges, float cellSize = 0);
+    void SetEdges(const linearWeightedEdgeList& edges);
+
+    vertIndex AddPoint(vec2 pos);
+    void MovePoint(vertIndex index, vec2 pos);
+
+    size_t GetPointCount() const { return m_Points.size(); }
+    const pointList& GetPoints() const { return m_Points; }
+
+    // Same results as the brute force FindNearestPoint and FindNearestEdge, -1 and FLT_MAX when empty.
+    std::pair<vertIndex, float> FindNearestPoint(vec2 pos) const;
+    std::pair<int, float> FindNearestEdge(vec2 pos) const;
+
+    // Up to 'count' points, closest first.
+    vertIndexList FindNearestPoints(vec2 pos, size_t count) const;
+
+    // Points closer than radius, in no particular order.
+    vertIndexList FindPointsWithinRadius(vec2 pos, float radius) const;
+
+    // Batch queries, split across threads. Each result is the same as FindNearestPoint would give for that position.
+    // Sorting by Morton order runs queries that land in nearby cells together, which helps when positions are scattered.
+    vertIndexList FindNearestPointForEach(const pointList& positions, bool sortByMortonOrder = true) const;
+
+    // Fills a CV_32SC1 image with the index of the nearest point to each pixel center, -1 if there are no points.
+    void LabelImageByNearestPoint(cv::Mat& labelImage, ivec2 imageSize, const PointDomain& domain = PointDomain()) const;
+};
+
+#endif //__SpatialIndex_H__
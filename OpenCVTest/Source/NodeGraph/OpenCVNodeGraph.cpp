@@ -16,6 +16,7 @@ OpenCVNodeGraph::OpenCVNodeGraph(EngineCore* pEngineCore, OpenCVNodeTypeManager*
     m_GlobalImageScale = 1.0f;
     m_AutoRun = true;
     m_HoverPixelsToShow = 32.0f;
+    m_Seed = 0;
 
     m_Palette = GeneratePalette();
 }
@@ -73,6 +74,7 @@ void OpenCVNodeGraph::Save()
         // Create JSON string.
         cJSON* jNodeGraph = ExportAsJSONObject();
 		cJSON_AddNumberToObject( jNodeGraph, "m_GlobalImageScale", m_GlobalImageScale );
+		cJSON_AddNumberToObject( jNodeGraph, "m_Seed", m_Seed );
 
         char* jsonString = cJSON_Print( jNodeGraph );
 
@@ -126,6 +128,7 @@ void OpenCVNodeGraph::ImportFromJSONObject(cJSON* jNodeGraph)
 	MyNodeGraph::ImportFromJSONObject( jNodeGraph );
 
 	cJSONExt_GetFloat( jNodeGraph, "m_GlobalImageScale", &m_GlobalImageScale );
+	cJSONExt_GetInt( jNodeGraph, "m_Seed", &m_Seed );
 }
 
 void OpenCVNodeGraph::AddItemsAboveNodeGraphWindow()
@@ -142,6 +145,10 @@ void OpenCVNodeGraph::AddItemsAboveNodeGraphWindow()
     ImGui::SameLine();
     ImGui::PushItemWidth( 100 );
     ImGui::DragFloat( "Hover Pixels", &m_HoverPixelsToShow, 1.0f, 1.0f, 64.0f );
+
+    ImGui::SameLine();
+    ImGui::PushItemWidth( 100 );
+    ImGui::DragInt( "Seed", &m_Seed, 1.0f );
     
     ImGui::SameLine( ImGui::GetWindowWidth() - 300 );
     ImGui::Checkbox( "Show grid", &m_GridVisible );
@@ -20,6 +20,7 @@ protected:
     bool m_AutoRun;
     float m_HoverPixelsToShow;
     colorPalette m_Palette;
+    int m_Seed; // Graph wide seed, mixed into every node's random streams.
 
 protected:
     // File IO.
@@ -49,6 +50,7 @@ public:
     bool GetAutoRun() { return m_AutoRun; }
     float GetHoverPixelsToShow() { return m_HoverPixelsToShow; }
     colorPalette& GetPalette() { return m_Palette; }
+    uint32 GetSeed() { return (uint32)m_Seed; }
 };
 
 //====================================================================================================
@@ -9,6 +9,7 @@
 #include "OpenCVNodes_Base.h"
 #include "OpenCVNodes_Core.h"
 #include "OpenCVNodes_Face.h"
+#include "OpenCVNodes_Frequency.h"
 #include "OpenCVNodes_Generators.h"
 #include "OpenCVNodes_Noise.h"
 #include "OpenCVNodes_Mask.h"
@@ -33,6 +34,7 @@ MyNodeGraph::MyNode* OpenCVNodeTypeManager::AddCreateNodeItemsToContextMenu(Vect
     if( ImGui::BeginMenu( "Generate" ) )
     {
         if( ImGui::MenuItem( "PoissonSampling" ) ) { ImGui::EndMenu(); return CreateNode( "Generate_PoissonSampling", pos, pNodeGraph ); }
+        if( ImGui::MenuItem( "LowDiscrepancy" ) )  { ImGui::EndMenu(); return CreateNode( "Generate_LowDiscrepancy", pos, pNodeGraph ); }
         if( ImGui::MenuItem( "RegularGrid" ) )     { ImGui::EndMenu(); return CreateNode( "Generate_RegularGrid", pos, pNodeGraph ); }
         if( ImGui::BeginMenu( "Noise" ) )
         {
@@ -46,6 +48,7 @@ MyNodeGraph::MyNode* OpenCVNodeTypeManager::AddCreateNodeItemsToContextMenu(Vect
     {
         if( ImGui::MenuItem( "Crop" ) )      { ImGui::EndMenu(); return CreateNode( "Convert_Crop", pos, pNodeGraph ); }
         if( ImGui::MenuItem( "Grayscale" ) ) { ImGui::EndMenu(); return CreateNode( "Convert_Grayscale", pos, pNodeGraph ); }
+        if( ImGui::MenuItem( "Pyramid" ) )   { ImGui::EndMenu(); return CreateNode( "Convert_Pyramid", pos, pNodeGraph ); }
         ImGui::EndMenu();
     }
 
@@ -58,6 +61,14 @@ MyNodeGraph::MyNode* OpenCVNodeTypeManager::AddCreateNodeItemsToContextMenu(Vect
         ImGui::EndMenu();
     }
 
+    if( ImGui::BeginMenu( "Frequency" ) )
+    {
+        if( ImGui::MenuItem( "DFT" ) )         { ImGui::EndMenu(); return CreateNode( "Frequency_DFT", pos, pNodeGraph ); }
+        if( ImGui::MenuItem( "Filter" ) )      { ImGui::EndMenu(); return CreateNode( "Frequency_Filter", pos, pNodeGraph ); }
+        if( ImGui::MenuItem( "Inverse DFT" ) ) { ImGui::EndMenu(); return CreateNode( "Frequency_InverseDFT", pos, pNodeGraph ); }
+        ImGui::EndMenu();
+    }
+
     if( ImGui::BeginMenu( "Face" ) )
     {
         if( ImGui::MenuItem( "Detect" ) )    { ImGui::EndMenu(); return CreateNode( "Face_Detect", pos, pNodeGraph ); }
@@ -76,14 +87,19 @@ MyNodeGraph::MyNode* OpenCVNodeTypeManager::CreateNode(const char* typeName, Vec
     if( TypeIs( "File_Input" )                  return MyNew OpenCVNode_File_Input(                 (OpenCVNodeGraph*)pNodeGraph, newNodeID, "Input", pos );
     if( TypeIs( "File_Output" )                 return MyNew OpenCVNode_File_Output(                (OpenCVNodeGraph*)pNodeGraph, newNodeID, "Output", pos );
     if( TypeIs( "Generate_PoissonSampling" )    return MyNew OpenCVNode_Generate_PoissonSampling(   (OpenCVNodeGraph*)pNodeGraph, newNodeID, "PoissonSampling", pos );
+    if( TypeIs( "Generate_LowDiscrepancy" )     return MyNew OpenCVNode_Generate_LowDiscrepancy(    (OpenCVNodeGraph*)pNodeGraph, newNodeID, "LowDiscrepancy", pos );
     if( TypeIs( "Generate_RegularGrid" )        return MyNew OpenCVNode_Generate_RegularGrid(       (OpenCVNodeGraph*)pNodeGraph, newNodeID, "RegularGrid", pos );
     if( TypeIs( "Generate_SimplexNoise" )       return MyNew OpenCVNode_Generate_SimplexNoise(      (OpenCVNodeGraph*)pNodeGraph, newNodeID, "Simplex Noise", pos );
     if( TypeIs( "Convert_Grayscale" )           return MyNew OpenCVNode_Convert_Grayscale(          (OpenCVNodeGraph*)pNodeGraph, newNodeID, "Grayscale", pos );
     if( TypeIs( "Convert_Crop" )                return MyNew OpenCVNode_Convert_Crop(               (OpenCVNodeGraph*)pNodeGraph, newNodeID, "Crop", pos );
+    if( TypeIs( "Convert_Pyramid" )             return MyNew OpenCVNode_Convert_Pyramid(            (OpenCVNodeGraph*)pNodeGraph, newNodeID, "Pyramid", pos );
     if( TypeIs( "Filter_Mask" )                 return MyNew OpenCVNode_Filter_Mask(                (OpenCVNodeGraph*)pNodeGraph, newNodeID, "Mask", pos );
     if( TypeIs( "Filter_Threshold" )            return MyNew OpenCVNode_Filter_Threshold(           (OpenCVNodeGraph*)pNodeGraph, newNodeID, "Threshold", pos );
     if( TypeIs( "Filter_Bilateral" )            return MyNew OpenCVNode_Filter_Bilateral(           (OpenCVNodeGraph*)pNodeGraph, newNodeID, "Bilateral", pos );
     if( TypeIs( "Filter_Morphological" )        return MyNew OpenCVNode_Filter_Morphological(       (OpenCVNodeGraph*)pNodeGraph, newNodeID, "Morph", pos );
+    if( TypeIs( "Frequency_DFT" )               return MyNew OpenCVNode_Frequency_DFT(              (OpenCVNodeGraph*)pNodeGraph, newNodeID, "DFT", pos );
+    if( TypeIs( "Frequency_Filter" )            return MyNew OpenCVNode_Frequency_Filter(           (OpenCVNodeGraph*)pNodeGraph, newNodeID, "FrequencyFilter", pos );
+    if( TypeIs( "Frequency_InverseDFT" )        return MyNew OpenCVNode_Frequency_InverseDFT(       (OpenCVNodeGraph*)pNodeGraph, newNodeID, "InverseDFT", pos );
     if( TypeIs( "Face_Detect" )                 return MyNew OpenCVNode_Face_Detect(                (OpenCVNodeGraph*)pNodeGraph, newNodeID, "FaceDetect", pos );
 
 #undef TypeIs
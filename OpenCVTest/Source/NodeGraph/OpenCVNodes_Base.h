@@ -41,9 +41,19 @@ public:
 
     virtual cv::Mat* GetValueMat() { return nullptr; }
     virtual std::vector<vec2>* GetValuePointList() { return nullptr; }
+    virtual std::vector<cv::Rect>* GetValueRectList() { return nullptr; }
+    virtual cv::Size GetValueSpatialSize() { return cv::Size( 0, 0 ); } // For frequency domain outputs, size of the source image.
+    virtual std::vector<cv::Mat>* GetValueImagePyramid() { return nullptr; } // Level 0 is full res, each level after is half size.
 
     virtual void TriggerGlobalRun() {}
 
+    // Each node draws from its own streams, keyed by the graph seed and the node ID,
+    //   so results don't depend on the order nodes run in or how work is split across threads.
+    RandomStream GetRandomStream(uint32 nodeSeed, uint32 purpose = 0)
+    {
+        return RandomStream( m_pNodeGraph->GetSeed(), (uint32)m_ID, purpose, nodeSeed );
+    }
+
     void QuickRun(bool triggerJustThisNodeIfAutoRunIsOff)
     {
         if( m_pNodeGraph->GetAutoRun() ) 
@@ -152,6 +162,34 @@ public:
 
         return nullptr;
     }
+
+    std::vector<cv::Rect>* GetInputRectList(uint32 slotID)
+    {
+        // Get a rect list from input node.
+        OpenCVBaseNode* pNode = static_cast<OpenCVBaseNode*>( m_pNodeGraph->FindNodeConnectedToInput( m_ID, slotID ) );
+        if( pNode )
+        {
+            std::vector<cv::Rect>* pRectList = pNode->GetValueRectList();
+            if( pRectList != nullptr )
+                return pRectList;
+        }
+
+        return nullptr;
+    }
+
+    std::vector<cv::Mat>* GetInputImagePyramid(uint32 slotID)
+    {
+        // Get an image pyramid from input node.
+        OpenCVBaseNode* pNode = static_cast<OpenCVBaseNode*>( m_pNodeGraph->FindNodeConnectedToInput( m_ID, slotID ) );
+        if( pNode )
+        {
+            std::vector<cv::Mat>* pPyramid = pNode->GetValueImagePyramid();
+            if( pPyramid != nullptr && pPyramid->empty() == false && (*pPyramid)[0].empty() == false )
+                return pPyramid;
+        }
+
+        return nullptr;
+    }
 };
 
 inline OpenCVBaseNode::TriggerFlags operator~(OpenCVBaseNode::TriggerFlags o)
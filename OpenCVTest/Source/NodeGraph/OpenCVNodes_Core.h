@@ -18,6 +18,7 @@ class OpenCVNode_File_Input;
 class OpenCVNode_File_Output;
 class OpenCVNode_Convert_Grayscale;
 class OpenCVNode_Convert_Crop;
+class OpenCVNode_Convert_Pyramid;
 class OpenCVNode_Filter_Threshold;
 class OpenCVNode_Filter_Bilateral;
 class OpenCVNode_Filter_Morphological;
@@ -510,6 +511,138 @@ public:
     virtual cv::Mat* GetValueMat() override { return &m_Image; }
 };
 
+//====================================================================================================
+// OpenCVNode_Convert_Pyramid
+//====================================================================================================
+static const char* m_OpenCVNode_Convert_Pyramid_InputLabels[] = { "Image Input" };
+static const char* m_OpenCVNode_Convert_Pyramid_OutputLabels[] = { "Level Output" };
+
+class OpenCVNode_Convert_Pyramid : public OpenCVBaseNode
+{
+protected:
+    std::vector<cv::Mat> m_Levels;
+    cv::Mat m_Image; // Header pointing at the output level, no pixels are copied.
+
+    TextureDefinition* m_pTexture;
+    int m_PreviewLevel;
+
+    int m_MaxLevels;
+    bool m_Gaussian;
+    int m_OutputLevel;
+
+public:
+    OpenCVNode_Convert_Pyramid(OpenCVNodeGraph* pNodeGraph, OpenCVNodeGraph::NodeID id, const char* name, const Vector2& pos)
+        : OpenCVBaseNode( pNodeGraph, id, name, pos, 1, 1 )
+    {
+        m_pTexture = nullptr;
+        m_PreviewLevel = -1;
+
+        m_MaxLevels = 6;
+        m_Gaussian = false;
+        m_OutputLevel = 0;
+
+        m_InputTooltips  = m_OpenCVNode_Convert_Pyramid_InputLabels;
+        m_OutputTooltips = m_OpenCVNode_Convert_Pyramid_OutputLabels;
+    }
+
+    ~OpenCVNode_Convert_Pyramid()
+    {
+        SAFE_RELEASE( m_pTexture );
+    }
+
+    const char* GetType() { return "Convert_Pyramid"; }
+
+    virtual void DrawTitle() override
+    {
+        if( m_Expanded )
+        {
+            OpenCVBaseNode::DrawTitle();
+        }
+        else
+        {
+            ImGui::Text( "%s", m_Name );
+        }
+    }
+
+    virtual bool DrawContents() override
+    {
+        OpenCVBaseNode::DrawContents();
+
+        ImGui::DragInt( "Max Levels", &m_MaxLevels, 0.1f, 1, 16 );
+        if( ImGui::IsItemDeactivatedAfterEdit() ) { QuickRun( false ); }
+        if( ImGui::Checkbox( "Gaussian", &m_Gaussian ) ) { QuickRun( false ); }
+        ImGui::DragInt( "Output Level", &m_OutputLevel, 0.1f, 0, m_MaxLevels-1 );
+        if( ImGui::IsItemDeactivatedAfterEdit() ) { QuickRun( false ); }
+
+        ImGui::Text( "Levels: %d", (int)m_Levels.size() );
+        ImGui::Text( "Runtime: %f", m_LastProcessTime );
+
+        // Upload the smallest level that still covers the display width, rather than the full res image.
+        if( m_Levels.empty() == false )
+        {
+            int level = PickPyramidLevel( m_Levels, GetDisplayWidth() );
+            if( level != m_PreviewLevel )
+            {
+                m_pTexture = CreateOrUpdateTextureDefinitionFromOpenCVMat( &m_Levels[level], m_pTexture );
+                m_PreviewLevel = level;
+            }
+
+            DisplayOpenCVMatAndTexture( &m_Levels[level], m_pTexture, GetDisplayWidth(), m_pNodeGraph->GetHoverPixelsToShow() );
+        }
+
+        return false;
+    }
+
+    virtual bool Trigger(MyEvent* pEvent, TriggerFlags triggerFlags) override
+    {
+        //OpenCVBaseNode::Trigger( pEvent );
+
+        // Get Image from input node.
+        cv::Mat* pImage = GetInputImage( 0 );
+
+        if( pImage )
+        {
+            double timeBefore = MyTime_GetSystemTime();
+
+            BuildImagePyramid( *pImage, m_Levels, m_MaxLevels, m_Gaussian );
+
+            MyClamp( m_OutputLevel, 0, (int)m_Levels.size() - 1 );
+            m_Image = m_Levels[m_OutputLevel];
+
+            double timeAfter = MyTime_GetSystemTime();
+            m_LastProcessTime = timeAfter - timeBefore;
+
+            // Force the preview texture to update next time the node is drawn.
+            m_PreviewLevel = -1;
+
+            // Trigger the output nodes.
+            TriggerOutputNodes( pEvent, triggerFlags & TriggerFlags::TF_Recursive );
+        }
+
+        return false;
+    }
+
+    virtual cJSON* ExportAsJSONObject() override
+    {
+        cJSON* jNode = OpenCVBaseNode::ExportAsJSONObject();
+        cJSON_AddNumberToObject( jNode, "m_MaxLevels", m_MaxLevels );
+        cJSON_AddNumberToObject( jNode, "m_Gaussian", m_Gaussian );
+        cJSON_AddNumberToObject( jNode, "m_OutputLevel", m_OutputLevel );
+        return jNode;
+    }
+
+    virtual void ImportFromJSONObject(cJSON* jNode) override
+    {
+        OpenCVBaseNode::ImportFromJSONObject( jNode );
+        cJSONExt_GetInt( jNode, "m_MaxLevels", &m_MaxLevels );
+        cJSONExt_GetBool( jNode, "m_Gaussian", &m_Gaussian );
+        cJSONExt_GetInt( jNode, "m_OutputLevel", &m_OutputLevel );
+    }
+
+    virtual cv::Mat* GetValueMat() override { return &m_Image; }
+    virtual std::vector<cv::Mat>* GetValueImagePyramid() override { return &m_Levels; }
+};
+
 //====================================================================================================
 // OpenCVNode_Filter_Threshold
 //====================================================================================================
@@ -0,0 +1,385 @@
+//
+// Copyright (c) 2019 Jimmy Lord http://www.flatheadgames.com
+//
+#include "OpenCVPCH.h"
+
+#include <atomic>
+
+#include "OpenCVNodes_Face.h"
+
+// Load classifiers from "Data/OpenCVHaarCascades" and "Data/OtherHaarCascades" directories.
+static const char* g_FaceCascadeFilename  = "Data/OpenCVHaarCascades/haarcascade_frontalface_default.xml";
+static const char* g_EyesCascadeFilename  = "Data/OpenCVHaarCascades/haarcascade_eye_tree_eyeglasses.xml";
+//static const char* g_MouthCascadeFilename = "Data/OpenCVHaarCascades/haarcascade_smile.xml";
+static const char* g_MouthCascadeFilename = "Data/OtherHaarCascades/haarcascade_mcs_mouth.xml";
+static const char* g_NoseCascadeFilename  = "Data/OtherHaarCascades/haarcascade_mcs_nose.xml";
+
+static cv::Rect OffsetRect(cv::Rect rect, cv::Point offset)
+{
+    return cv::Rect( rect.x + offset.x, rect.y + offset.y, rect.width, rect.height );
+}
+
+void OpenCVNode_Face_Detect::LoadClassifiers()
+{
+    // The classifiers are cached, so this only hits the disk for the first node that asks for them.
+    GetCachedCascadeClassifier( g_EyesCascadeFilename );
+    GetCachedCascadeClassifier( g_MouthCascadeFilename );
+    GetCachedCascadeClassifier( g_NoseCascadeFilename );
+    m_ClassifiersLoaded = GetCachedCascadeClassifier( g_FaceCascadeFilename ) != nullptr;
+}
+
+void OpenCVNode_Face_Detect::DetectFeaturesInFace(const cv::Mat& imageGray, FaceFeatures& features)
+{
+    // Called from worker threads, each thread gets its own copy of the classifiers from the cache.
+    cv::CascadeClassifier* pEyesClassifier = GetCachedCascadeClassifier( g_EyesCascadeFilename );
+    cv::CascadeClassifier* pNoseClassifier = GetCachedCascadeClassifier( g_NoseCascadeFilename );
+    cv::CascadeClassifier* pMouthClassifier = GetCachedCascadeClassifier( g_MouthCascadeFilename );
+
+    cv::Rect faceRect = features.face;
+
+    features.eyes.clear();
+    features.noses.clear();
+    features.mouths.clear();
+
+    if( faceRect.area() <= 0 )
+        return;
+
+    // Find the eyes.
+    std::vector<cv::Rect> eyeRects;
+    if( pEyesClassifier )
+    {
+        // Start with just the face region.
+        cv::Mat imageFace = imageGray( faceRect );
+        pEyesClassifier->detectMultiScale( imageFace, eyeRects );
+
+        for( const cv::Rect& eyeRect : eyeRects )
+            features.eyes.push_back( OffsetRect( eyeRect, faceRect.tl() ) );
+    }
+
+    // Find the nose.
+    std::vector<cv::Rect> noseRects;
+    cv::Rect faceBelowEyesRect = faceRect;
+    if( pNoseClassifier && eyeRects.size() > 0 )
+    {
+        // Start with just the face region below the eyes.
+        faceBelowEyesRect.y = faceRect.y + eyeRects[0].y + eyeRects[0].height/2;
+        faceBelowEyesRect.height -= faceBelowEyesRect.y - faceRect.y;
+        if( faceBelowEyesRect.height <= 0 )
+            return;
+
+        cv::Mat imageFace = imageGray( faceBelowEyesRect );
+        pNoseClassifier->detectMultiScale( imageFace, noseRects );
+
+        for( const cv::Rect& noseRect : noseRects )
+            features.noses.push_back( OffsetRect( noseRect, faceBelowEyesRect.tl() ) );
+    }
+
+    // Find the mouth.
+    if( pMouthClassifier && noseRects.size() > 0 )
+    {
+        // Start with just the face region below the nose.
+        cv::Rect faceBelowNoseRect = faceBelowEyesRect;
+        faceBelowNoseRect.y = faceBelowEyesRect.y + noseRects[0].y + noseRects[0].height/2;
+        faceBelowNoseRect.height -= faceBelowNoseRect.y - faceBelowEyesRect.y;
+        if( faceBelowNoseRect.height <= 0 )
+            return;
+
+        cv::Mat imageFace = imageGray( faceBelowNoseRect );
+
+        std::vector<cv::Rect> mouthRects;
+        pMouthClassifier->detectMultiScale( imageFace, mouthRects );
+
+        for( const cv::Rect& mouthRect : mouthRects )
+            features.mouths.push_back( OffsetRect( mouthRect, faceBelowNoseRect.tl() ) );
+    }
+}
+
+static void DrawFeatureCircles(cv::Mat& image, const std::vector<cv::Rect>& rects, cv::Scalar color)
+{
+    for( const cv::Rect& rect : rects )
+    {
+        cv::Point center( rect.x + rect.width/2, rect.y + rect.height/2 );
+        int radius = cvRound( (rect.width + rect.height) * 0.25 );
+        circle( image, center, radius, color, 4 );
+    }
+}
+
+void OpenCVNode_Face_Detect::DetectFaces(const cv::Mat& imageGray, std::vector<cv::Mat>* pPyramid)
+{
+    cv::CascadeClassifier* pFaceClassifier = GetCachedCascadeClassifier( g_FaceCascadeFilename );
+    if( pFaceClassifier == nullptr )
+        return;
+
+    // Find the faces, optionally on a downscaled copy of the image.
+    std::vector<cv::Rect> faceRects;
+    MyClamp( m_DetectionScale, 0.1f, 1.0f );
+    if( m_DetectionScale < 1.0f )
+    {
+        cv::Mat imageGraySmall;
+
+        // If the input came from a pyramid node, use its smallest level that's still big enough instead of resizing again.
+        int level = 0;
+        if( pPyramid && (*pPyramid)[0].size() == imageGray.size() )
+        {
+            level = PickPyramidLevel( *pPyramid, cvCeil( imageGray.cols * m_DetectionScale ) );
+        }
+
+        if( level > 0 )
+        {
+            cvtColor( (*pPyramid)[level], imageGraySmall, cv::COLOR_BGR2GRAY );
+            equalizeHist( imageGraySmall, imageGraySmall );
+        }
+        else
+        {
+            cv::resize( imageGray, imageGraySmall, cv::Size(), m_DetectionScale, m_DetectionScale, cv::INTER_AREA );
+        }
+
+        pFaceClassifier->detectMultiScale( imageGraySmall, faceRects );
+
+        // Map the rects back to full resolution.
+        float scaleX = (float)imageGraySmall.cols / imageGray.cols;
+        float scaleY = (float)imageGraySmall.rows / imageGray.rows;
+        cv::Rect imageRect( 0, 0, imageGray.cols, imageGray.rows );
+        for( cv::Rect& faceRect : faceRects )
+        {
+            faceRect = cv::Rect( cvRound( faceRect.x / scaleX ), cvRound( faceRect.y / scaleY ),
+                                 cvRound( faceRect.width / scaleX ), cvRound( faceRect.height / scaleY ) ) & imageRect;
+        }
+    }
+    else
+    {
+        pFaceClassifier->detectMultiScale( imageGray, faceRects );
+    }
+
+    m_Faces.resize( faceRects.size() );
+    for( size_t i=0; i<faceRects.size(); i++ )
+    {
+        m_Faces[i].face = faceRects[i];
+    }
+}
+
+bool OpenCVNode_Face_Detect::TrackFaces(const cv::Mat& imageGray)
+{
+    // Follow each face from the previous frame by matching its old pixels in a window around the old rect.
+    // Returns false if any face drifted, in which case the caller should run a full detection.
+    std::atomic<bool> lostFace( false );
+    cv::Rect imageRect( 0, 0, imageGray.cols, imageGray.rows );
+
+    cv::parallel_for_( cv::Range( 0, (int)m_Faces.size() ), [&](const cv::Range& range)
+    {
+        for( int i=range.start; i<range.end && lostFace == false; i++ )
+        {
+            cv::Rect faceRect = m_Faces[i].face;
+
+            // Search half a face in every direction.
+            cv::Rect searchRect( faceRect.x - faceRect.width/2, faceRect.y - faceRect.height/2, faceRect.width*2, faceRect.height*2 );
+            searchRect &= imageRect;
+            if( faceRect.area() <= 0 || searchRect.width < faceRect.width || searchRect.height < faceRect.height )
+            {
+                lostFace = true;
+                break;
+            }
+
+            // Match at reduced resolution, a face doesn't need more than a few dozen pixels across to be followed.
+            double scale = std::min( 1.0, 48.0 / faceRect.width );
+            cv::Mat templ = m_PreviousGray( faceRect );
+            cv::Mat search = imageGray( searchRect );
+            if( scale < 1.0 )
+            {
+                cv::resize( templ, templ, cv::Size(), scale, scale, cv::INTER_AREA );
+                cv::resize( search, search, cv::Size(), scale, scale, cv::INTER_AREA );
+            }
+
+            cv::Mat result;
+            cv::matchTemplate( search, templ, result, cv::TM_CCOEFF_NORMED );
+
+            double maxValue;
+            cv::Point maxLoc;
+            cv::minMaxLoc( result, nullptr, &maxValue, nullptr, &maxLoc );
+
+            if( maxValue < m_MinTrackingMatch )
+            {
+                lostFace = true;
+                break;
+            }
+
+            m_Faces[i].face.x = searchRect.x + cvRound( maxLoc.x / scale );
+            m_Faces[i].face.y = searchRect.y + cvRound( maxLoc.y / scale );
+            m_Faces[i].face &= imageRect;
+        }
+    } );
+
+    return lostFace == false;
+}
+
+void OpenCVNode_Face_Detect::DrawOverlay(cv::Mat& image) const
+{
+    for( const FaceFeatures& features : m_Faces )
+    {
+        // Draw a blue rectangle around the face, blue circles around the eyes,
+        //     red circles around the nose and green circles around the mouth.
+        rectangle( image, features.face, cv::Scalar( 255, 0, 0 ), 4 );
+        DrawFeatureCircles( image, features.eyes, cv::Scalar( 255, 0, 0 ) );
+        DrawFeatureCircles( image, features.noses, cv::Scalar( 0, 0, 255 ) );
+        DrawFeatureCircles( image, features.mouths, cv::Scalar( 0, 255, 0 ) );
+    }
+}
+
+void OpenCVNode_Face_Detect::UpdatePreview()
+{
+    if( m_ShowOverlay && m_BurnInOverlay == false && m_Image.empty() == false )
+    {
+        m_Image.copyTo( m_PreviewImage );
+        DrawOverlay( m_PreviewImage );
+    }
+    else
+    {
+        m_PreviewImage = m_Image;
+    }
+
+    m_pTexture = CreateOrUpdateTextureDefinitionFromOpenCVMat( &m_PreviewImage, m_pTexture );
+    m_PreviewDirty = false;
+}
+
+bool OpenCVNode_Face_Detect::DrawContents()
+{
+    bool modified = OpenCVBaseNode::DrawContents();
+
+    if( m_ClassifiersLoaded == false )
+    {
+        ImGui::Text( "Haar cascades not loaded." );
+        if( ImGui::Button( "Load" ) )
+        {
+            LoadClassifiers();
+        }
+    }
+
+    ImGui::DragFloat( "Detect Scale", &m_DetectionScale, 0.01f, 0.1f, 1.0f );
+    if( ImGui::IsItemDeactivatedAfterEdit() ) { QuickRun( false ); }
+
+    if( ImGui::Checkbox( "Tracking", &m_TrackingEnabled ) ) { m_FramesSinceDetection = 0; QuickRun( false ); }
+    if( m_TrackingEnabled )
+    {
+        ImGui::DragInt( "Redetect Every", &m_RedetectInterval, 1.0f, 1, 120 );
+        ImGui::DragFloat( "Min Match", &m_MinTrackingMatch, 0.01f, 0.0f, 1.0f );
+    }
+
+    if( ImGui::Checkbox( "Show Overlay", &m_ShowOverlay ) ) { m_PreviewDirty = true; }
+    ImGui::SameLine();
+    if( ImGui::Checkbox( "Burn In", &m_BurnInOverlay ) ) { QuickRun( false ); }
+
+    ImGui::Text( "Faces: %d", (int)m_Faces.size() );
+    ImGui::Text( "Runtime: %f", m_LastProcessTime );
+
+    // The preview is only built when the node is actually drawn.
+    if( m_PreviewDirty )
+    {
+        UpdatePreview();
+    }
+
+    DisplayOpenCVMatAndTexture( &m_PreviewImage, m_pTexture, GetDisplayWidth(), m_pNodeGraph->GetHoverPixelsToShow() );
+
+    return modified;
+}
+
+bool OpenCVNode_Face_Detect::Trigger(MyEvent* pEvent, TriggerFlags triggerFlags)
+{
+    if( m_ClassifiersLoaded == false )
+        return false;
+
+    //OpenCVBaseNode::Trigger( pEvent );
+
+    // Get Image from input node.
+    cv::Mat* pImage = GetInputImage( 0 );
+
+    if( pImage )
+    {
+        double timeBefore = MyTime_GetSystemTime();
+
+        cv::Mat imageGray;
+        cvtColor( *pImage, imageGray, cv::COLOR_BGR2GRAY );
+        equalizeHist( imageGray, imageGray );
+
+        // Run a full detection every m_RedetectInterval frames, or when tracking loses a face.
+        // With no faces to track, keep detecting every frame so new faces are picked up as soon as they appear.
+        bool needsDetection = true;
+        if( m_TrackingEnabled && m_Faces.empty() == false && m_FramesSinceDetection < m_RedetectInterval && m_PreviousGray.size() == imageGray.size() )
+        {
+            needsDetection = TrackFaces( imageGray ) == false;
+        }
+
+        if( needsDetection )
+        {
+            DetectFaces( imageGray, GetInputImagePyramid( 0 ) );
+            m_FramesSinceDetection = 0;
+        }
+        else
+        {
+            m_FramesSinceDetection++;
+        }
+
+        m_PreviousGray = imageGray;
+
+        // Find the eyes, nose and mouth of each face in parallel, confined to the detected or tracked face rects.
+        cv::parallel_for_( cv::Range( 0, (int)m_Faces.size() ), [&](const cv::Range& range)
+        {
+            for( int i=range.start; i<range.end; i++ )
+            {
+                DetectFeaturesInFace( imageGray, m_Faces[i] );
+            }
+        } );
+
+        m_FaceRects.resize( m_Faces.size() );
+        for( size_t i=0; i<m_Faces.size(); i++ )
+        {
+            m_FaceRects[i] = m_Faces[i].face;
+        }
+
+        if( m_BurnInOverlay )
+        {
+            // Make a copy of the source image, we'll draw shapes into this one.
+            // Release first, m_Image might still be sharing the input's pixels from a pass-through run.
+            m_Image.release();
+            pImage->copyTo( m_Image );
+            DrawOverlay( m_Image );
+        }
+        else
+        {
+            // Pass the input through without copying, downstream nodes can use the rect list.
+            m_Image = *pImage;
+        }
+
+        double timeAfter = MyTime_GetSystemTime();
+        m_LastProcessTime = timeAfter - timeBefore;
+
+        m_PreviewDirty = true;
+
+        // Trigger the output nodes.
+        TriggerOutputNodes( pEvent, triggerFlags & TriggerFlags::TF_Recursive );
+    }
+
+    return false;
+}
+
+cJSON* OpenCVNode_Face_Detect::ExportAsJSONObject()
+{
+    cJSON* jNode = OpenCVBaseNode::ExportAsJSONObject();
+    cJSON_AddNumberToObject( jNode, "m_DetectionScale", m_DetectionScale );
+    cJSON_AddNumberToObject( jNode, "m_TrackingEnabled", m_TrackingEnabled );
+    cJSON_AddNumberToObject( jNode, "m_RedetectInterval", m_RedetectInterval );
+    cJSON_AddNumberToObject( jNode, "m_MinTrackingMatch", m_MinTrackingMatch );
+    cJSON_AddNumberToObject( jNode, "m_ShowOverlay", m_ShowOverlay );
+    cJSON_AddNumberToObject( jNode, "m_BurnInOverlay", m_BurnInOverlay );
+    return jNode;
+}
+
+void OpenCVNode_Face_Detect::ImportFromJSONObject(cJSON* jNode)
+{
+    OpenCVBaseNode::ImportFromJSONObject( jNode );
+    cJSONExt_GetFloat( jNode, "m_DetectionScale", &m_DetectionScale );
+    cJSONExt_GetBool( jNode, "m_TrackingEnabled", &m_TrackingEnabled );
+    cJSONExt_GetInt( jNode, "m_RedetectInterval", &m_RedetectInterval );
+    cJSONExt_GetFloat( jNode, "m_MinTrackingMatch", &m_MinTrackingMatch );
+    cJSONExt_GetBool( jNode, "m_ShowOverlay", &m_ShowOverlay );
+    cJSONExt_GetBool( jNode, "m_BurnInOverlay", &m_BurnInOverlay );
+}
@@ -0,0 +1,327 @@
+//
+// Copyright (c) 2022 Jimmy Lord
+//
+#include "OpenCVPCH.h"
+#include "OpenCVNodes_Frequency.h"
+
+//====================================================================================================
+// OpenCVNode_Frequency_DFT
+//====================================================================================================
+
+OpenCVNode_Frequency_DFT::OpenCVNode_Frequency_DFT(OpenCVNodeGraph* pNodeGraph, OpenCVNodeGraph::NodeID id, const char* name, const Vector2& pos)
+    : OpenCVBaseNode( pNodeGraph, id, name, pos, 1, 1 )
+{
+}
+
+OpenCVNode_Frequency_DFT::~OpenCVNode_Frequency_DFT()
+{
+    SAFE_RELEASE( m_pTexture );
+}
+
+void OpenCVNode_Frequency_DFT::DrawTitle()
+{
+    if( m_Expanded )
+        OpenCVBaseNode::DrawTitle();
+    else
+        ImGui::Text( "%s", m_Name );
+}
+
+bool OpenCVNode_Frequency_DFT::DrawContents()
+{
+    bool modified = OpenCVBaseNode::DrawContents();
+
+    ImGui::Text( "Size: %dx%d -> %dx%d", m_SpatialSize.width, m_SpatialSize.height, m_Spectrum.cols, m_Spectrum.rows );
+    ImGui::Text( "Runtime: %f", m_LastProcessTime );
+
+    // The magnitude preview is only built when the node is actually drawn.
+    if( m_PreviewDirty && m_Spectrum.empty() == false )
+    {
+        GetLogMagnitudeFromPackedDFT( m_Spectrum, m_PreviewImage );
+        m_pTexture = CreateOrUpdateTextureDefinitionFromOpenCVMat( &m_PreviewImage, m_pTexture );
+        m_PreviewDirty = false;
+    }
+
+    AdjustKnownImageWidth( m_PreviewImage.cols );
+    DisplayOpenCVMatAndTexture( &m_PreviewImage, m_pTexture, GetDisplayWidth(), m_pNodeGraph->GetHoverPixelsToShow() );
+
+    return modified;
+}
+
+bool OpenCVNode_Frequency_DFT::Trigger(MyEvent* pEvent, TriggerFlags triggerFlags)
+{
+    //OpenCVBaseNode::Trigger( pEvent );
+
+    // Get Image from input node.
+    cv::Mat* pImage = GetInputImage( 0 );
+
+    if( pImage )
+    {
+        double timeBefore = MyTime_GetSystemTime();
+
+        cv::Mat gray = *pImage;
+        if( pImage->channels() == 3 )
+        {
+            cv::cvtColor( *pImage, m_Gray, cv::COLOR_BGR2GRAY );
+            gray = m_Gray;
+        }
+        else if( pImage->channels() == 4 )
+        {
+            cv::cvtColor( *pImage, m_Gray, cv::COLOR_BGRA2GRAY );
+            gray = m_Gray;
+        }
+
+        m_SpatialSize = gray.size();
+        cv::Size dftSize( GetOptimalEvenDFTSize( gray.cols ), GetOptimalEvenDFTSize( gray.rows ) );
+
+        // Copy the image into the top left of the zero padded buffer, the buffer is only reallocated if the size changes.
+        m_PaddedInput.create( dftSize, CV_32F );
+        gray.convertTo( m_PaddedInput( cv::Rect( 0, 0, gray.cols, gray.rows ) ), CV_32F, GetUnitScaleForDepth( gray.depth() ) );
+        m_PaddedInput( cv::Rect( gray.cols, 0, dftSize.width - gray.cols, dftSize.height ) ).setTo( 0 );
+        m_PaddedInput( cv::Rect( 0, gray.rows, gray.cols, dftSize.height - gray.rows ) ).setTo( 0 );
+
+        // Real input with packed output, telling OpenCV the padding rows are zero lets it skip them.
+        cv::dft( m_PaddedInput, m_Spectrum, 0, gray.rows );
+
+        double timeAfter = MyTime_GetSystemTime();
+        m_LastProcessTime = timeAfter - timeBefore;
+
+        m_PreviewDirty = true;
+
+        // Trigger the output nodes.
+        TriggerOutputNodes( pEvent, triggerFlags & TriggerFlags::TF_Recursive );
+    }
+
+    return false;
+}
+
+//====================================================================================================
+// OpenCVNode_Frequency_Filter
+//====================================================================================================
+
+OpenCVNode_Frequency_Filter::OpenCVNode_Frequency_Filter(OpenCVNodeGraph* pNodeGraph, OpenCVNodeGraph::NodeID id, const char* name, const Vector2& pos)
+    : OpenCVBaseNode( pNodeGraph, id, name, pos, 1, 1 )
+{
+}
+
+OpenCVNode_Frequency_Filter::~OpenCVNode_Frequency_Filter()
+{
+    SAFE_RELEASE( m_pTexture );
+}
+
+void OpenCVNode_Frequency_Filter::BuildKernelSpectrum(cv::Size dftSize)
+{
+    // Build the spatial kernel centered on 0,0 and wrapped around the edges, so the filter doesn't shift the image.
+    cv::Mat kernel;
+    if( m_FilterType == FilterType::Box )
+    {
+        int size = std::min( m_BoxSize, std::min( dftSize.width, dftSize.height ) );
+        kernel = cv::Mat::ones( size, size, CV_32F ) / (float)(size*size);
+    }
+    else
+    {
+        int halfSize = (int)ceil( m_Sigma * 3 );
+        halfSize = std::max( 1, std::min( halfSize, std::min( dftSize.width, dftSize.height )/2 - 1 ) );
+        cv::Mat kernel1D = cv::getGaussianKernel( halfSize*2 + 1, m_Sigma, CV_32F );
+        kernel = kernel1D * kernel1D.t();
+
+        // A high pass is the original image minus the low pass one.
+        if( m_FilterType == FilterType::GaussianHighPass )
+        {
+            kernel *= -1;
+            kernel.at<float>( halfSize, halfSize ) += 1.0f;
+        }
+    }
+
+    cv::Mat kernelPadded = cv::Mat::zeros( dftSize, CV_32F );
+    int center = kernel.rows / 2;
+    for( int y=0; y<kernel.rows; y++ )
+    {
+        int wrappedY = (y - center + dftSize.height) % dftSize.height;
+        for( int x=0; x<kernel.cols; x++ )
+        {
+            int wrappedX = (x - center + dftSize.width) % dftSize.width;
+            kernelPadded.at<float>( wrappedY, wrappedX ) += kernel.at<float>( y, x );
+        }
+    }
+
+    // The rows above the center wrap around to the bottom of the image, so every row can be nonzero.
+    cv::dft( kernelPadded, m_KernelSpectrum, 0 );
+    m_KernelDirty = false;
+}
+
+void OpenCVNode_Frequency_Filter::DrawTitle()
+{
+    if( m_Expanded )
+        OpenCVBaseNode::DrawTitle();
+    else
+        ImGui::Text( "%s", m_Name );
+}
+
+bool OpenCVNode_Frequency_Filter::DrawContents()
+{
+    bool modified = OpenCVBaseNode::DrawContents();
+
+    if( ImGui::BeginCombo( "Type", FilterTypeNames[(int)m_FilterType].c_str() ) )
+    {
+        for( int n = 0; n < (int)FilterType::NumTypes; n++ )
+        {
+            bool is_selected = (n == (int)m_FilterType);
+            if( ImGui::Selectable( FilterTypeNames[n].c_str(), is_selected ) )
+            {
+                m_FilterType = (FilterType)n;
+                m_KernelDirty = true;
+                QuickRun( false );
+            }
+            if( is_selected )
+            {
+                ImGui::SetItemDefaultFocus();
+            }
+        }
+        ImGui::EndCombo();
+    }
+
+    if( m_FilterType == FilterType::Box )
+    {
+        ImGui::DragInt( "Size", &m_BoxSize, 1.0f, 1, 1024 );
+    }
+    else
+    {
+        ImGui::DragFloat( "Sigma", &m_Sigma, 0.1f, 0.1f, 500.0f );
+    }
+    if( ImGui::IsItemDeactivatedAfterEdit() ) { m_KernelDirty = true; QuickRun( false ); }
+
+    ImGui::Text( "Runtime: %f", m_LastProcessTime );
+
+    // The magnitude preview is only built when the node is actually drawn.
+    if( m_PreviewDirty && m_Spectrum.empty() == false )
+    {
+        GetLogMagnitudeFromPackedDFT( m_Spectrum, m_PreviewImage );
+        m_pTexture = CreateOrUpdateTextureDefinitionFromOpenCVMat( &m_PreviewImage, m_pTexture );
+        m_PreviewDirty = false;
+    }
+
+    AdjustKnownImageWidth( m_PreviewImage.cols );
+    DisplayOpenCVMatAndTexture( &m_PreviewImage, m_pTexture, GetDisplayWidth(), m_pNodeGraph->GetHoverPixelsToShow() );
+
+    return modified;
+}
+
+bool OpenCVNode_Frequency_Filter::Trigger(MyEvent* pEvent, TriggerFlags triggerFlags)
+{
+    //OpenCVBaseNode::Trigger( pEvent );
+
+    // Get the spectrum from the input node.
+    OpenCVBaseNode* pNode = static_cast<OpenCVBaseNode*>( m_pNodeGraph->FindNodeConnectedToInput( m_ID, 0 ) );
+    cv::Mat* pSpectrum = GetInputImage( 0 );
+
+    // Only frequency nodes report a spatial size, any other CV_32F image isn't a packed spectrum.
+    if( pNode && pSpectrum && pSpectrum->type() == CV_32F && pNode->GetValueSpatialSize().width > 0 )
+    {
+        double timeBefore = MyTime_GetSystemTime();
+
+        m_SpatialSize = pNode->GetValueSpatialSize();
+
+        if( m_KernelDirty || m_KernelSpectrum.size() != pSpectrum->size() )
+        {
+            BuildKernelSpectrum( pSpectrum->size() );
+        }
+
+        // Convolution in the spatial domain is a per element multiply here.
+        cv::mulSpectrums( *pSpectrum, m_KernelSpectrum, m_Spectrum, 0 );
+
+        double timeAfter = MyTime_GetSystemTime();
+        m_LastProcessTime = timeAfter - timeBefore;
+
+        m_PreviewDirty = true;
+
+        // Trigger the output nodes.
+        TriggerOutputNodes( pEvent, triggerFlags & TriggerFlags::TF_Recursive );
+    }
+
+    return false;
+}
+
+cJSON* OpenCVNode_Frequency_Filter::ExportAsJSONObject()
+{
+    cJSON* jNode = OpenCVBaseNode::ExportAsJSONObject();
+    cJSON_AddNumberToObject( jNode, "m_FilterType", (int)m_FilterType );
+    cJSON_AddNumberToObject( jNode, "m_Sigma", m_Sigma );
+    cJSON_AddNumberToObject( jNode, "m_BoxSize", m_BoxSize );
+    return jNode;
+}
+
+void OpenCVNode_Frequency_Filter::ImportFromJSONObject(cJSON* jNode)
+{
+    OpenCVBaseNode::ImportFromJSONObject( jNode );
+    cJSONExt_GetInt( jNode, "m_FilterType", (int*)&m_FilterType );
+    cJSONExt_GetFloat( jNode, "m_Sigma", &m_Sigma );
+    cJSONExt_GetInt( jNode, "m_BoxSize", &m_BoxSize );
+    m_KernelDirty = true;
+}
+
+//====================================================================================================
+// OpenCVNode_Frequency_InverseDFT
+//====================================================================================================
+
+OpenCVNode_Frequency_InverseDFT::OpenCVNode_Frequency_InverseDFT(OpenCVNodeGraph* pNodeGraph, OpenCVNodeGraph::NodeID id, const char* name, const Vector2& pos)
+    : OpenCVBaseNode( pNodeGraph, id, name, pos, 1, 1 )
+{
+}
+
+OpenCVNode_Frequency_InverseDFT::~OpenCVNode_Frequency_InverseDFT()
+{
+    SAFE_RELEASE( m_pTexture );
+}
+
+void OpenCVNode_Frequency_InverseDFT::DrawTitle()
+{
+    if( m_Expanded )
+        OpenCVBaseNode::DrawTitle();
+    else
+        ImGui::Text( "%s", m_Name );
+}
+
+bool OpenCVNode_Frequency_InverseDFT::DrawContents()
+{
+    bool modified = OpenCVBaseNode::DrawContents();
+
+    ImGui::Text( "Runtime: %f", m_LastProcessTime );
+
+    AdjustKnownImageWidth( m_Image.cols );
+    DisplayOpenCVMatAndTexture( &m_Image, m_pTexture, GetDisplayWidth(), m_pNodeGraph->GetHoverPixelsToShow() );
+
+    return modified;
+}
+
+bool OpenCVNode_Frequency_InverseDFT::Trigger(MyEvent* pEvent, TriggerFlags triggerFlags)
+{
+    //OpenCVBaseNode::Trigger( pEvent );
+
+    // Get the spectrum from the input node.
+    OpenCVBaseNode* pNode = static_cast<OpenCVBaseNode*>( m_pNodeGraph->FindNodeConnectedToInput( m_ID, 0 ) );
+    cv::Mat* pSpectrum = GetInputImage( 0 );
+
+    if( pNode && pSpectrum && pSpectrum->type() == CV_32F )
+    {
+        double timeBefore = MyTime_GetSystemTime();
+
+        cv::Size spatialSize = pNode->GetValueSpatialSize();
+        if( spatialSize.width == 0 || spatialSize.width > pSpectrum->cols || spatialSize.height > pSpectrum->rows )
+            spatialSize = pSpectrum->size();
+
+        // Packed input back to a real image, then crop off the padding.
+        // Only the first spatialSize.height rows of the output are needed.
+        cv::dft( *pSpectrum, m_PaddedOutput, cv::DFT_INVERSE | cv::DFT_REAL_OUTPUT | cv::DFT_SCALE, spatialSize.height );
+        m_PaddedOutput( cv::Rect( 0, 0, spatialSize.width, spatialSize.height ) ).convertTo( m_Image, CV_8U, 255.0 );
+
+        double timeAfter = MyTime_GetSystemTime();
+        m_LastProcessTime = timeAfter - timeBefore;
+
+        m_pTexture = CreateOrUpdateTextureDefinitionFromOpenCVMat( &m_Image, m_pTexture );
+
+        // Trigger the output nodes.
+        TriggerOutputNodes( pEvent, triggerFlags & TriggerFlags::TF_Recursive );
+    }
+
+    return false;
+}
@@ -0,0 +1,134 @@
+//
+// Copyright (c) 2022 Jimmy Lord
+//
+#ifndef __OpenCVNodes_Frequency_H__
+#define __OpenCVNodes_Frequency_H__
+
+#include "OpenCVNodes_Base.h"
+#include "Utility/Helpers.h"
+
+// OpenCV node types.
+class OpenCVNode_Frequency_DFT;
+class OpenCVNode_Frequency_Filter;
+class OpenCVNode_Frequency_InverseDFT;
+
+// Frequency domain nodes pass spectrums around as CV_32F mats in OpenCV's packed (CCS) format.
+// Sizes are padded up to even optimal DFT sizes, GetValueSpatialSize() returns the original image size.
+
+//====================================================================================================
+// OpenCVNode_Frequency_DFT
+//====================================================================================================
+
+class OpenCVNode_Frequency_DFT : public OpenCVBaseNode
+{
+protected:
+    cv::Mat m_Spectrum;
+    cv::Size m_SpatialSize = cv::Size( 0, 0 );
+
+    // Work buffers, kept around so runs at the same size don't reallocate.
+    cv::Mat m_Gray;
+    cv::Mat m_PaddedInput;
+
+    cv::Mat m_PreviewImage;
+    TextureDefinition* m_pTexture = nullptr;
+    bool m_PreviewDirty = false;
+
+public:
+    OpenCVNode_Frequency_DFT(OpenCVNodeGraph* pNodeGraph, OpenCVNodeGraph::NodeID id, const char* name, const Vector2& pos);
+    ~OpenCVNode_Frequency_DFT();
+
+    DEFINE_NODE_TYPE( "Frequency_DFT" );
+
+    virtual void DrawTitle() override;
+    virtual bool DrawContents() override;
+    virtual bool Trigger(MyEvent* pEvent, TriggerFlags triggerFlags) override;
+
+    virtual cv::Mat* GetValueMat() override { return &m_Spectrum; }
+    virtual cv::Size GetValueSpatialSize() override { return m_SpatialSize; }
+};
+
+//====================================================================================================
+// OpenCVNode_Frequency_Filter
+//====================================================================================================
+
+class OpenCVNode_Frequency_Filter : public OpenCVBaseNode
+{
+public:
+    enum class FilterType
+    {
+        GaussianLowPass,
+        GaussianHighPass,
+        Box,
+        NumTypes,
+    };
+
+    inline static std::string FilterTypeNames[(int)FilterType::NumTypes]
+    {
+        "Gaussian Low Pass",
+        "Gaussian High Pass",
+        "Box",
+    };
+
+protected:
+    cv::Mat m_Spectrum;
+    cv::Size m_SpatialSize = cv::Size( 0, 0 );
+
+    // Spectrum of the filter kernel, only rebuilt when the size or settings change.
+    cv::Mat m_KernelSpectrum;
+    bool m_KernelDirty = true;
+
+    cv::Mat m_PreviewImage;
+    TextureDefinition* m_pTexture = nullptr;
+    bool m_PreviewDirty = false;
+
+    // Saved parameters.
+    FilterType m_FilterType = FilterType::GaussianLowPass;
+    float m_Sigma = 10.0f;
+    int m_BoxSize = 31;
+
+public:
+    OpenCVNode_Frequency_Filter(OpenCVNodeGraph* pNodeGraph, OpenCVNodeGraph::NodeID id, const char* name, const Vector2& pos);
+    ~OpenCVNode_Frequency_Filter();
+
+    DEFINE_NODE_TYPE( "Frequency_Filter" );
+
+    void BuildKernelSpectrum(cv::Size dftSize);
+
+    virtual void DrawTitle() override;
+    virtual bool DrawContents() override;
+    virtual bool Trigger(MyEvent* pEvent, TriggerFlags triggerFlags) override;
+
+    virtual cJSON* ExportAsJSONObject() override;
+    virtual void ImportFromJSONObject(cJSON* jNode) override;
+
+    virtual cv::Mat* GetValueMat() override { return &m_Spectrum; }
+    virtual cv::Size GetValueSpatialSize() override { return m_SpatialSize; }
+};
+
+//====================================================================================================
+// OpenCVNode_Frequency_InverseDFT
+//====================================================================================================
+
+class OpenCVNode_Frequency_InverseDFT : public OpenCVBaseNode
+{
+protected:
+    cv::Mat m_Image;
+    TextureDefinition* m_pTexture = nullptr;
+
+    // Work buffer, kept around so runs at the same size don't reallocate.
+    cv::Mat m_PaddedOutput;
+
+public:
+    OpenCVNode_Frequency_InverseDFT(OpenCVNodeGraph* pNodeGraph, OpenCVNodeGraph::NodeID id, const char* name, const Vector2& pos);
+    ~OpenCVNode_Frequency_InverseDFT();
+
+    DEFINE_NODE_TYPE( "Frequency_InverseDFT" );
+
+    virtual void DrawTitle() override;
+    virtual bool DrawContents() override;
+    virtual bool Trigger(MyEvent* pEvent, TriggerFlags triggerFlags) override;
+
+    virtual cv::Mat* GetValueMat() override { return &m_Image; }
+};
+
+#endif //__OpenCVNodes_Frequency_H__
@@ -4,33 +4,24 @@
 #include "OpenCVPCH.h"
 #include "OpenCVNodes_Generators.h"
 #include "Graph/GraphHelpers.h"
+#include "Graph/GraphRenderers.h"
 
 // Implementation of Robert Bridson's "Fast Poisson Disk Sampling in Arbitrary Dimensions".
 // https://www.cs.ubc.ca/~rbridson/docs/bridson-siggraph07-poissondisk.pdf
 // Implemented solely in 2D, which probably defeats the purpose.
-void GenerateSampling(std::vector<vec2>& pointList, float minDistance, int maxSamplesPerPoint, bool startWithExistingPoints)
+void GenerateSampling(std::vector<vec2>& pointList, float minDistance, int maxSamplesPerPoint, bool startWithExistingPoints, RandomStream& stream, const PointDomain& domain)
 {
     if( minDistance < 0.0001 )
         return;
 
     float r = minDistance;
 
-    vec2 pointSpaceSize( 100.0f, 100.0f );
-
     // Temp variables.
     std::vector<vec2> activeList;
     float cellSize = r / sqrtf(2);
-    ivec2 gridSize( (int)ceil(pointSpaceSize.x / cellSize), (int)ceil(pointSpaceSize.y / cellSize) );
+    ivec2 gridSize( (int)ceil(domain.size.x / cellSize), (int)ceil(domain.size.y / cellSize) );
     std::vector<vec2> pointGrid( gridSize.x*gridSize.y );
-
-    // Initialize the grid.
-    for( int y=0; y<gridSize.y; y++ )
-    {
-        for( int x=0; x<gridSize.x; x++ )
-        {
-            pointGrid[y*gridSize.x + x].Set( -1, -1 );
-        }
-    }
+    std::vector<bool> cellUsed( gridSize.x*gridSize.y, false );
 
     if( startWithExistingPoints )
     {
@@ -39,24 +30,29 @@ void GenerateSampling(std::vector<vec2>& pointList, float minDistance, int maxSa
         {
             // Grad the old point.
             vec2 pos = pointList[i-1];
-            int gx = (int)(pos.x / cellSize);
-            int gy = (int)(pos.y / cellSize);
+            int gx = std::min( (int)((pos.x - domain.origin.x) / cellSize), gridSize.x-1 );
+            int gy = std::min( (int)((pos.y - domain.origin.y) / cellSize), gridSize.y-1 );
 
             // Push the sample into the active list and color the pixel.
             activeList.push_back( pos );
             pointGrid[gy*gridSize.x + gx] = pos;
+            cellUsed[gy*gridSize.x + gx] = true;
         }
     }
     else
     {
         // Pick a random point.
-        vec2 pos( randFloat(0,(float)pointSpaceSize.x), randFloat(0,(float)pointSpaceSize.y) );
-        int gx = (int)(pos.x / cellSize);
-        int gy = (int)(pos.y / cellSize);
+        // Separate statements, argument evaluation order isn't defined.
+        float x = stream.NextFloat( 0, domain.size.x );
+        float y = stream.NextFloat( 0, domain.size.y );
+        vec2 pos( domain.origin.x + x, domain.origin.y + y );
+        int gx = (int)(x / cellSize);
+        int gy = (int)(y / cellSize);
 
         // Push the sample into the active list and color the pixel.
         activeList.push_back( pos );
         pointGrid[gy*gridSize.x + gx] = pos;
+        cellUsed[gy*gridSize.x + gx] = true;
         pointList.clear();
         pointList.push_back( pos );
     }
@@ -72,16 +68,16 @@ void GenerateSampling(std::vector<vec2>& pointList, float minDistance, int maxSa
         // Check a maximum number of samples around our current position.
         for( int i=0; i<maxSamplesPerPoint; i++ )
         {
-            float angle = randFloat( 0, 2*PI );
+            float angle = stream.NextFloat( 0, 2*PI );
             vec2 dir( cos(angle), sin(angle) );
-            float dist = randFloat( r, 2*r );
+            float dist = stream.NextFloat( r, 2*r );
 
             vec2 pos = currentPos + dir * dist;
-            int ngx = (int)(pos.x / cellSize);
-            int ngy = (int)(pos.y / cellSize);
+            int ngx = (int)floor((pos.x - domain.origin.x) / cellSize);
+            int ngy = (int)floor((pos.y - domain.origin.y) / cellSize);
 
             // Out of bounds check.
-            if( pos.x < 0 || pos.x >= pointSpaceSize.x || pos.y < 0 || pos.y >= pointSpaceSize.y ||
+            if( domain.Contains( pos ) == false ||
                 ngx < 0 || ngx >= gridSize.x || ngy < 0 || ngy >= gridSize.y )
             {
                 continue;
@@ -98,7 +94,7 @@ void GenerateSampling(std::vector<vec2>& pointList, float minDistance, int maxSa
                     if( tile.x < 0 || tile.x >= gridSize.x ) continue;
                     if( tile.y < 0 || tile.y >= gridSize.y ) continue;
 
-                    if( pointGrid[tileIndex].x != -1 )
+                    if( cellUsed[tileIndex] )
                     {
                         float distance = pointGrid[tileIndex].DistanceFrom( pos );
 
@@ -116,6 +112,7 @@ void GenerateSampling(std::vector<vec2>& pointList, float minDistance, int maxSa
             {
                 activeList.push_back( pos );
                 pointGrid[ngy*gridSize.x + ngx] = pos;
+                cellUsed[ngy*gridSize.x + ngx] = true;
                 pointList.push_back( pos );
                 //cv::Vec3b color = cv::Vec3b( 255, 255, 255 );
                 //if( palette != nullptr )
@@ -127,8 +124,502 @@ void GenerateSampling(std::vector<vec2>& pointList, float minDistance, int maxSa
     }
 }
 
-void DrawSampling(cv::Mat& image, ivec2 imageSize, const std::vector<vec2>& pointList, const colorPalette* palette, const std::vector<size_t> pointListLayerStarts)
+// Multiple layers of the above, each layer's distance is the previous one divided by reductionRate.
+// Cells hold linked lists of point indices, so when a layer starts the grid is refined to the new distance by relinking
+//   the existing points rather than testing them again. Only the points added by the previous layer go back on the active list,
+//   new points grow out from those into the rest of the space.
+void GenerateLayeredSampling(std::vector<vec2>& pointList, std::vector<size_t>& layerStarts, float minDistance, float reductionRate, int numLayers, int maxSamplesPerPoint, RandomStream& stream, const PointDomain& domain)
+{
+    pointList.clear();
+    layerStarts.clear();
+    layerStarts.push_back( 0 );
+
+    // Temp variables.
+    std::vector<int> activeList;
+    std::vector<int> cellHeads; // First point in each cell, -1 if empty.
+    std::vector<int> next;      // Next point in the same cell, -1 at the end of the list.
+    ivec2 gridSize;
+
+    float r = minDistance;
+    for( int layer=0; layer<numLayers; layer++ )
+    {
+        if( r < 0.0001 )
+            break;
+
+        // Cells are as wide as the minimum distance, so only the 3x3 cells around a point need checking.
+        float cellSize = r;
+        gridSize.Set( (int)ceil(domain.size.x / cellSize), (int)ceil(domain.size.y / cellSize) );
+
+        auto linkPoint = [&](int index)
+        {
+            int gx = std::min( (int)((pointList[index].x - domain.origin.x) / cellSize), gridSize.x-1 );
+            int gy = std::min( (int)((pointList[index].y - domain.origin.y) / cellSize), gridSize.y-1 );
+            int& head = cellHeads[gy*gridSize.x + gx];
+            next[index] = head;
+            head = index;
+        };
+
+        auto addPoint = [&](vec2 pos)
+        {
+            int index = (int)pointList.size();
+            pointList.push_back( pos );
+            next.push_back( -1 );
+            linkPoint( index );
+            activeList.push_back( index );
+        };
+
+        // Refine the grid to this layer's cell size.
+        cellHeads.assign( gridSize.x * gridSize.y, -1 );
+        next.resize( pointList.size() );
+        for( int i=0; i<(int)pointList.size(); i++ )
+        {
+            linkPoint( i );
+        }
+
+        // Seed the layer.
+        activeList.clear();
+        if( layer == 0 )
+        {
+            float x = stream.NextFloat( 0, domain.size.x );
+            float y = stream.NextFloat( 0, domain.size.y );
+            addPoint( vec2( domain.origin.x + x, domain.origin.y + y ) );
+        }
+        else
+        {
+            for( size_t i=layerStarts[layer-1]; i<layerStarts[layer]; i++ )
+            {
+                activeList.push_back( (int)i );
+            }
+        }
+
+        float rSquared = r * r;
+
+        // Loop through active list.
+        while( activeList.size() > 0 )
+        {
+            // Remove this sample from the active list.
+            vec2 currentPos = pointList[activeList[0]];
+            activeList[0] = activeList[activeList.size()-1];
+            activeList.pop_back();
+
+            // Check a maximum number of samples around our current position.
+            for( int i=0; i<maxSamplesPerPoint; i++ )
+            {
+                float angle = stream.NextFloat( 0, 2*PI );
+                vec2 dir( cos(angle), sin(angle) );
+                float dist = stream.NextFloat( r, 2*r );
+
+                vec2 pos = currentPos + dir * dist;
+
+                // Out of bounds check.
+                if( domain.Contains( pos ) == false )
+                {
+                    continue;
+                }
+
+                // Check all neighbouring grid cells.
+                int ngx = (int)((pos.x - domain.origin.x) / cellSize);
+                int ngy = (int)((pos.y - domain.origin.y) / cellSize);
+                bool tooClose = false;
+                for( int y=std::max( ngy-1, 0 ); y<=std::min( ngy+1, gridSize.y-1 ) && tooClose == false; y++ )
+                {
+                    for( int x=std::max( ngx-1, 0 ); x<=std::min( ngx+1, gridSize.x-1 ) && tooClose == false; x++ )
+                    {
+                        for( int p=cellHeads[y*gridSize.x + x]; p!=-1; p=next[p] )
+                        {
+                            float dx = pointList[p].x - pos.x;
+                            float dy = pointList[p].y - pos.y;
+                            if( dx*dx + dy*dy < rSquared )
+                            {
+                                tooClose = true;
+                                break;
+                            }
+                        }
+                    }
+                }
+
+                // If we found a spot far enough from all others, push the sample into the active list.
+                if( tooClose == false )
+                {
+                    addPoint( pos );
+                }
+            }
+        }
+
+        layerStarts.push_back( pointList.size() );
+        r /= reductionRate;
+    }
+}
+
+// Parallel version of GenerateSampling.
+// The grid is split into square tiles at least 3 cells (> 2r) wide, and tiles are filled in 4 phases
+//   so that no two tiles filled at the same time are adjacent. A tile only writes to its own cells
+//   and only reads up to 2 cells outside of itself, so same phase tiles never touch the same cells.
+// Each tile has its own random stream derived from the tile index, and new points are
+//   appended in tile order, so the results only depend on the stream and not on the number of threads.
+// The grid holds positions relative to the domain origin, so -1 can still mark an empty cell.
+void GenerateSamplingParallel(std::vector<vec2>& pointList, float minDistance, int maxSamplesPerPoint, bool startWithExistingPoints, const RandomStream& stream, const PointDomain& domain)
+{
+    if( minDistance < 0.0001 )
+        return;
+
+    float r = minDistance;
+
+    vec2 pointSpaceSize = domain.size;
+
+    float cellSize = r / sqrtf(2);
+    ivec2 gridSize( (int)ceil(pointSpaceSize.x / cellSize), (int)ceil(pointSpaceSize.y / cellSize) );
+    std::vector<vec2> pointGrid( gridSize.x*gridSize.y, vec2( -1, -1 ) );
+
+    // Tile size is fixed, not based on the thread count, to keep the results deterministic.
+    const int cellsPerTile = 32;
+    ivec2 tileCount( (gridSize.x + cellsPerTile - 1) / cellsPerTile, (gridSize.y + cellsPerTile - 1) / cellsPerTile );
+
+    if( startWithExistingPoints )
+    {
+        for( const vec2& worldPos : pointList )
+        {
+            vec2 pos( worldPos.x - domain.origin.x, worldPos.y - domain.origin.y );
+            int gx = std::min( (int)(pos.x / cellSize), gridSize.x-1 );
+            int gy = std::min( (int)(pos.y / cellSize), gridSize.y-1 );
+            pointGrid[gy*gridSize.x + gx] = pos;
+        }
+    }
+    else
+    {
+        pointList.clear();
+    }
+
+    std::vector<std::vector<vec2>> tilePointLists( tileCount.x*tileCount.y );
+
+    auto isTooClose = [&](vec2 pos, int ngx, int ngy)
+    {
+        // Cells are r/sqrt(2) wide, so points up to 2 cells away can be within r.
+        for( int y=ngy-2; y<=ngy+2; y++ )
+        {
+            if( y < 0 || y >= gridSize.y ) continue;
+            for( int x=ngx-2; x<=ngx+2; x++ )
+            {
+                if( x < 0 || x >= gridSize.x ) continue;
+
+                const vec2& other = pointGrid[y*gridSize.x + x];
+                if( other.x != -1 && other.DistanceFrom( pos ) < r )
+                    return true;
+            }
+        }
+        return false;
+    };
+
+    auto fillTile = [&](int tx, int ty)
+    {
+        int tileIndex = ty*tileCount.x + tx;
+        std::vector<vec2>& tilePoints = tilePointLists[tileIndex];
+
+        int cx0 = tx*cellsPerTile;
+        int cy0 = ty*cellsPerTile;
+        int cx1 = std::min( cx0 + cellsPerTile, gridSize.x );
+        int cy1 = std::min( cy0 + cellsPerTile, gridSize.y );
+
+        RandomStream tileStream = stream.Substream( tileIndex );
+
+        // Start with any points already in or right around this tile, so growth continues across tile edges.
+        std::vector<vec2> activeList;
+        for( int y=std::max( cy0-2, 0 ); y<std::min( cy1+2, gridSize.y ); y++ )
+        {
+            for( int x=std::max( cx0-2, 0 ); x<std::min( cx1+2, gridSize.x ); x++ )
+            {
+                if( pointGrid[y*gridSize.x + x].x != -1 )
+                    activeList.push_back( pointGrid[y*gridSize.x + x] );
+            }
+        }
+
+        // Also try a random point inside the tile, needed for tiles in the first phase.
+        {
+            float x = tileStream.NextFloat( (float)cx0, (float)cx1 );
+            float y = tileStream.NextFloat( (float)cy0, (float)cy1 );
+            vec2 pos( x * cellSize, y * cellSize );
+            int gx = (int)(pos.x / cellSize);
+            int gy = (int)(pos.y / cellSize);
+            if( pos.x < pointSpaceSize.x && pos.y < pointSpaceSize.y && gx < cx1 && gy < cy1 && isTooClose( pos, gx, gy ) == false )
+            {
+                activeList.push_back( pos );
+                pointGrid[gy*gridSize.x + gx] = pos;
+                tilePoints.push_back( vec2( domain.origin.x + pos.x, domain.origin.y + pos.y ) );
+            }
+        }
+
+        // Loop through active list.
+        while( activeList.size() > 0 )
+        {
+            // Remove a random sample from the active list.
+            size_t activeIndex = std::min( (size_t)(tileStream.NextFloat( 0.0f, 1.0f ) * activeList.size()), activeList.size()-1 );
+            vec2 currentPos = activeList[activeIndex];
+            activeList[activeIndex] = activeList[activeList.size()-1];
+            activeList.pop_back();
+
+            // Check a maximum number of samples around our current position.
+            for( int i=0; i<maxSamplesPerPoint; i++ )
+            {
+                float angle = tileStream.NextFloat( 0.0f, 1.0f ) * 2*PI;
+                vec2 dir( cos(angle), sin(angle) );
+                float dist = r + tileStream.NextFloat( 0.0f, 1.0f ) * r;
+
+                vec2 pos = currentPos + dir * dist;
+                if( pos.x < 0 || pos.x >= pointSpaceSize.x || pos.y < 0 || pos.y >= pointSpaceSize.y )
+                    continue;
+
+                // Only accept points that land inside this tile.
+                int ngx = (int)(pos.x / cellSize);
+                int ngy = (int)(pos.y / cellSize);
+                if( ngx < cx0 || ngx >= cx1 || ngy < cy0 || ngy >= cy1 )
+                    continue;
+
+                if( isTooClose( pos, ngx, ngy ) == false )
+                {
+                    activeList.push_back( pos );
+                    pointGrid[ngy*gridSize.x + ngx] = pos;
+                    tilePoints.push_back( vec2( domain.origin.x + pos.x, domain.origin.y + pos.y ) );
+                }
+            }
+        }
+    };
+
+    // Fill tiles in 4 phases, tiles in the same phase are at least one tile apart.
+    for( int phase=0; phase<4; phase++ )
+    {
+        int phaseX = phase % 2;
+        int phaseY = phase / 2;
+        int phaseTilesX = (tileCount.x - phaseX + 1) / 2;
+        int phaseTilesY = (tileCount.y - phaseY + 1) / 2;
+
+        cv::parallel_for_( cv::Range( 0, phaseTilesX*phaseTilesY ), [&](const cv::Range& range)
+        {
+            for( int i=range.start; i<range.end; i++ )
+            {
+                fillTile( phaseX + (i % phaseTilesX)*2, phaseY + (i / phaseTilesX)*2 );
+            }
+        } );
+    }
+
+    // Append the new points in tile order.
+    size_t totalCount = pointList.size();
+    for( const std::vector<vec2>& tilePoints : tilePointLists )
+        totalCount += tilePoints.size();
+
+    pointList.reserve( totalCount );
+    for( const std::vector<vec2>& tilePoints : tilePointLists )
+        pointList.insert( pointList.end(), tilePoints.begin(), tilePoints.end() );
+}
+
+// Large domain version of GenerateSamplingParallel, the domain is split into square chunks that each build their own small grid,
+//   so memory use follows the chunk size and point count rather than the size of the whole domain.
+// Chunks are filled in the same 4 phases as the tiles above. Each chunk starts from the points of its neighbouring chunks
+//   (and any existing points) that lie within r of its edges, so points along the seams keep the same minimum distance.
+void GenerateSamplingChunked(std::vector<vec2>& pointList, float minDistance, int maxSamplesPerPoint, bool startWithExistingPoints, float chunkSize, const RandomStream& stream, const PointDomain& domain)
 {
+    if( minDistance < 0.0001 )
+        return;
+
+    if( startWithExistingPoints == false )
+        pointList.clear();
+
+    float r = minDistance;
+
+    // Chunks need to be at least r wide so only the 8 surrounding chunks can hold points within r.
+    chunkSize = std::max( chunkSize, r );
+    ivec2 chunkCount( (int)ceil(domain.size.x / chunkSize), (int)ceil(domain.size.y / chunkSize) );
+
+    auto chunkIndexOf = [&](vec2 pos)
+    {
+        int cx = std::min( std::max( (int)((pos.x - domain.origin.x) / chunkSize), 0 ), chunkCount.x-1 );
+        int cy = std::min( std::max( (int)((pos.y - domain.origin.y) / chunkSize), 0 ), chunkCount.y-1 );
+        return cy*chunkCount.x + cx;
+    };
+
+    // Existing points are bucketed by chunk so each chunk only looks at the ones nearby.
+    std::vector<std::vector<vec2>> existingChunkPointLists( chunkCount.x*chunkCount.y );
+    for( const vec2& pos : pointList )
+    {
+        existingChunkPointLists[chunkIndexOf( pos )].push_back( pos );
+    }
+
+    std::vector<std::vector<vec2>> chunkPointLists( chunkCount.x*chunkCount.y );
+
+    auto fillChunk = [&](int chunkX, int chunkY)
+    {
+        int chunkIndex = chunkY*chunkCount.x + chunkX;
+        std::vector<vec2>& chunkPoints = chunkPointLists[chunkIndex];
+
+        RandomStream chunkStream = stream.Substream( chunkIndex );
+
+        // Chunk bounds, the last row and column are clipped to the domain.
+        vec2 domainMax = domain.GetMax();
+        vec2 chunkMin( domain.origin.x + chunkX*chunkSize, domain.origin.y + chunkY*chunkSize );
+        vec2 chunkMax( std::min( chunkMin.x + chunkSize, domainMax.x ), std::min( chunkMin.y + chunkSize, domainMax.y ) );
+
+        // The chunk's grid covers the chunk plus a border r wide for the neighbouring points.
+        float cellSize = r / sqrtf(2);
+        vec2 gridMin( chunkMin.x - r, chunkMin.y - r );
+        ivec2 gridSize( (int)ceil((chunkMax.x - chunkMin.x + 2*r) / cellSize), (int)ceil((chunkMax.y - chunkMin.y + 2*r) / cellSize) );
+        std::vector<int> cellPoints( gridSize.x*gridSize.y, -1 );
+        std::vector<vec2> gridPoints;
+
+        auto cellOf = [&](vec2 pos)
+        {
+            int gx = std::min( std::max( (int)((pos.x - gridMin.x) / cellSize), 0 ), gridSize.x-1 );
+            int gy = std::min( std::max( (int)((pos.y - gridMin.y) / cellSize), 0 ), gridSize.y-1 );
+            return ivec2( gx, gy );
+        };
+
+        auto isTooClose = [&](vec2 pos, ivec2 cell)
+        {
+            // Cells are r/sqrt(2) wide, so points up to 2 cells away can be within r.
+            for( int y=std::max( cell.y-2, 0 ); y<=std::min( cell.y+2, gridSize.y-1 ); y++ )
+            {
+                for( int x=std::max( cell.x-2, 0 ); x<=std::min( cell.x+2, gridSize.x-1 ); x++ )
+                {
+                    int index = cellPoints[y*gridSize.x + x];
+                    if( index != -1 && gridPoints[index].DistanceFrom( pos ) < r )
+                        return true;
+                }
+            }
+            return false;
+        };
+
+        auto addToGrid = [&](vec2 pos)
+        {
+            ivec2 cell = cellOf( pos );
+            cellPoints[cell.y*gridSize.x + cell.x] = (int)gridPoints.size();
+            gridPoints.push_back( pos );
+        };
+
+        // Start with the points already in or right around this chunk, so growth continues across chunk edges.
+        std::vector<vec2> activeList;
+        for( int y=std::max( chunkY-1, 0 ); y<=std::min( chunkY+1, chunkCount.y-1 ); y++ )
+        {
+            for( int x=std::max( chunkX-1, 0 ); x<=std::min( chunkX+1, chunkCount.x-1 ); x++ )
+            {
+                int neighbourIndex = y*chunkCount.x + x;
+                for( const std::vector<vec2>* pList : { &existingChunkPointLists[neighbourIndex], &chunkPointLists[neighbourIndex] } )
+                {
+                    for( const vec2& pos : *pList )
+                    {
+                        if( pos.x >= gridMin.x && pos.x < chunkMax.x + r && pos.y >= gridMin.y && pos.y < chunkMax.y + r )
+                        {
+                            addToGrid( pos );
+                            activeList.push_back( pos );
+                        }
+                    }
+                }
+            }
+        }
+
+        // Also try a random point inside the chunk, needed for chunks in the first phase.
+        {
+            float x = chunkStream.NextFloat( chunkMin.x, chunkMax.x );
+            float y = chunkStream.NextFloat( chunkMin.y, chunkMax.y );
+            vec2 pos( x, y );
+            if( pos.x < chunkMax.x && pos.y < chunkMax.y && isTooClose( pos, cellOf( pos ) ) == false )
+            {
+                addToGrid( pos );
+                activeList.push_back( pos );
+                chunkPoints.push_back( pos );
+            }
+        }
+
+        // Loop through active list.
+        while( activeList.size() > 0 )
+        {
+            // Remove a random sample from the active list.
+            size_t activeIndex = std::min( (size_t)(chunkStream.NextFloat( 0.0f, 1.0f ) * activeList.size()), activeList.size()-1 );
+            vec2 currentPos = activeList[activeIndex];
+            activeList[activeIndex] = activeList[activeList.size()-1];
+            activeList.pop_back();
+
+            // Check a maximum number of samples around our current position.
+            for( int i=0; i<maxSamplesPerPoint; i++ )
+            {
+                float angle = chunkStream.NextFloat( 0.0f, 1.0f ) * 2*PI;
+                vec2 dir( cos(angle), sin(angle) );
+                float dist = r + chunkStream.NextFloat( 0.0f, 1.0f ) * r;
+
+                vec2 pos = currentPos + dir * dist;
+
+                // Only accept points that land inside this chunk.
+                if( pos.x < chunkMin.x || pos.x >= chunkMax.x || pos.y < chunkMin.y || pos.y >= chunkMax.y )
+                    continue;
+
+                if( isTooClose( pos, cellOf( pos ) ) == false )
+                {
+                    addToGrid( pos );
+                    activeList.push_back( pos );
+                    chunkPoints.push_back( pos );
+                }
+            }
+        }
+    };
+
+    // Fill chunks in 4 phases, chunks in the same phase are at least one chunk apart.
+    for( int phase=0; phase<4; phase++ )
+    {
+        int phaseX = phase % 2;
+        int phaseY = phase / 2;
+        int phaseChunksX = (chunkCount.x - phaseX + 1) / 2;
+        int phaseChunksY = (chunkCount.y - phaseY + 1) / 2;
+
+        cv::parallel_for_( cv::Range( 0, phaseChunksX*phaseChunksY ), [&](const cv::Range& range)
+        {
+            for( int i=range.start; i<range.end; i++ )
+            {
+                fillChunk( phaseX + (i % phaseChunksX)*2, phaseY + (i / phaseChunksX)*2 );
+            }
+        } );
+    }
+
+    // Append the new points in chunk order.
+    size_t totalCount = pointList.size();
+    for( const std::vector<vec2>& chunkPoints : chunkPointLists )
+        totalCount += chunkPoints.size();
+
+    pointList.reserve( totalCount );
+    for( const std::vector<vec2>& chunkPoints : chunkPointLists )
+        pointList.insert( pointList.end(), chunkPoints.begin(), chunkPoints.end() );
+}
+
+void DrawSampling(cv::Mat& image, ivec2 imageSize, const std::vector<vec2>& pointList, const colorPalette* palette, const std::vector<size_t> pointListLayerStarts, const PointDomain& domain)
+{
+    // Large lists only use one color and size per layer, so they can go through the batched rasterizer in one pass.
+    if( pointList.size() >= 1000 && image.type() == CV_8UC3 )
+    {
+        int numLayers = std::max( (int)pointListLayerStarts.size() - 1, 1 );
+
+        std::vector<SplatStyle> styles( numLayers );
+        for( int layer=0; layer<numLayers; layer++ )
+        {
+            if( palette != nullptr )
+                styles[layer] = { std::max( 10 - layer*2, 2 ), palette->at( layer+1 ), 0 };
+            else
+                styles[layer] = { std::max( 5 - layer*2, 1 ), cv::Vec3b( 255, 255, 255 ), 0 };
+        }
+
+        // Same order as below, last point first.
+        std::vector<cv::Point> centers( pointList.size() );
+        std::vector<uint8> styleIndices( pointList.size() );
+        int layer = numLayers-1;
+        for( size_t i=pointList.size(); i>0; i-- )
+        {
+            while( layer > 0 && i <= pointListLayerStarts[layer] )
+                layer--;
+
+            vec2 pos = domain.ToImage( pointList[i-1], imageSize );
+            centers[pointList.size() - i] = cv::Point( (int)pos.x, (int)pos.y );
+            styleIndices[pointList.size() - i] = (uint8)std::min( layer, 255 );
+        }
+
+        DrawPointSplats( image, centers, styleIndices, styles );
+        return;
+    }
+
     cv::Vec3b color = cv::Vec3b( 255, 255, 255 );
 
     bool colorEachVertex = true;
@@ -161,7 +652,7 @@ void DrawSampling(cv::Mat& image, ivec2 imageSize, const std::vector<vec2>& poin
             }
         }
 
-        vec2 pos = pointList[i-1] / 100.0f * vec2( (float)imageSize.x, (float)imageSize.y );
+        vec2 pos = domain.ToImage( pointList[i-1], imageSize );
 
         if( size < 1 )
             size = 1;
@@ -178,126 +669,339 @@ void DrawSampling(cv::Mat& image, ivec2 imageSize, const std::vector<vec2>& poin
     }
 }
 
+// Bilinear lookup into a single channel float image, coordinates are clamped to the image edges.
+static float SampleBilinear(const cv::Mat& image, float x, float y)
+{
+    x = std::min( std::max( x, 0.0f ), (float)(image.cols - 1) );
+    y = std::min( std::max( y, 0.0f ), (float)(image.rows - 1) );
+
+    int x0 = (int)x;
+    int y0 = (int)y;
+    int x1 = std::min( x0 + 1, image.cols - 1 );
+    int y1 = std::min( y0 + 1, image.rows - 1 );
+    float fx = x - x0;
+    float fy = y - y0;
+
+    const float* row0 = image.ptr<float>( y0 );
+    const float* row1 = image.ptr<float>( y1 );
+    float top = row0[x0] + (row0[x1] - row0[x0]) * fx;
+    float bottom = row1[x0] + (row1[x1] - row1[x0]) * fx;
+    return top + (bottom - top) * fy;
+}
+
 // Modification of the above that takes in a grayscale image that controls point density.
-void GenerateSamplingWithVaryingPointDensity(std::vector<vec2>& pointList, int maxSamplesPerPoint, cv::Mat& pointDensityImage, float minDistance, float maxDistance)
+// Points are kept in a multi-level grid, level n has cells minDistance * 2^n wide and each cell holds a linked list of points.
+// Each query uses the level with cells at least half of the query radius, so it never probes more than 5x5 cells
+//   no matter how far apart minDistance and maxDistance are.
+void GenerateSamplingWithVaryingPointDensity(std::vector<vec2>& pointList, int maxSamplesPerPoint, cv::Mat& pointDensityImage, float minDistance, float maxDistance, RandomStream& stream, const PointDomain& domain)
 {
-    float r = minDistance;
+    if( minDistance < 0.0001 )
+        return;
 
     if( maxDistance < minDistance )
         maxDistance = minDistance;
 
-    int halfMaxCellSpan = (int)ceil( maxDistance/minDistance );
+    vec2 pointSpaceSize = domain.size;
 
-    vec2 pointSpaceSize( 100.0f, 100.0f );
+    // Convert the density image into a map of desired distances once, rather than converting on every lookup.
+    cv::Mat radiusMap;
+    if( pointDensityImage.empty() == false )
+    {
+        cv::Mat gray = pointDensityImage;
+        if( pointDensityImage.channels() == 3 )
+            cv::cvtColor( pointDensityImage, gray, cv::COLOR_BGR2GRAY );
 
-    // Temp variables.
-    std::vector<vec2> activeList;
-    float cellSize = minDistance / sqrtf(2);
-    ivec2 gridSize( (int)ceil(pointSpaceSize.x / cellSize), (int)ceil(pointSpaceSize.y / cellSize) );
-    std::vector<vec2> pointGrid( gridSize.x*gridSize.y );
+        // 16-bit and float densities from the noise node are scaled by their own range, not 8-bit's.
+        gray.convertTo( radiusMap, CV_32F, (maxDistance - minDistance) * GetUnitScaleForDepth( gray.depth() ), minDistance );
+    }
 
-    // Initialize the grid.
-    for( int y=0; y<gridSize.y; y++ )
+    // Point space to density image pixels.
+    vec2 pointToPixel( 1, 1 );
+    if( radiusMap.empty() == false )
+        pointToPixel.Set( radiusMap.cols / pointSpaceSize.x, radiusMap.rows / pointSpaceSize.y );
+
+    // Set up the grid levels.
+    struct GridLevel
     {
-        for( int x=0; x<gridSize.x; x++ )
+        float cellSize;
+        ivec2 gridSize;
+        std::vector<int> cellHeads; // First point in each cell, -1 if empty.
+        std::vector<int> next;      // Next point in the same cell, -1 at the end of the list.
+    };
+
+    std::vector<GridLevel> levels;
+    for( float cellSize = minDistance; ; cellSize *= 2 )
+    {
+        GridLevel level;
+        level.cellSize = cellSize;
+        level.gridSize.Set( (int)ceil(pointSpaceSize.x / cellSize), (int)ceil(pointSpaceSize.y / cellSize) );
+        level.cellHeads.resize( level.gridSize.x * level.gridSize.y, -1 );
+        levels.push_back( std::move( level ) );
+
+        if( cellSize*2 >= maxDistance )
+            break;
+    }
+
+    std::vector<int> activeList;
+    pointList.clear();
+
+    auto addPoint = [&](vec2 pos)
+    {
+        int index = (int)pointList.size();
+        pointList.push_back( pos );
+        activeList.push_back( index );
+
+        for( GridLevel& level : levels )
         {
-            pointGrid[y*gridSize.x + x].Set( -1, -1 );
+            int gx = std::min( (int)((pos.x - domain.origin.x) / level.cellSize), level.gridSize.x-1 );
+            int gy = std::min( (int)((pos.y - domain.origin.y) / level.cellSize), level.gridSize.y-1 );
+            int& head = level.cellHeads[gy*level.gridSize.x + gx];
+            level.next.push_back( head );
+            head = index;
         }
-    }
+    };
 
-    // Pick a random point.
-    vec2 pos( randFloat(0,(float)pointSpaceSize.x), randFloat(0,(float)pointSpaceSize.y) );
-    int gx = (int)(pos.x / cellSize);
-    int gy = (int)(pos.y / cellSize);
+    auto isTooClose = [&](vec2 pos, float radius)
+    {
+        // Smallest level with cells of at least half the radius, so the span is at most 2 cells.
+        size_t levelIndex = 0;
+        while( levelIndex+1 < levels.size() && levels[levelIndex].cellSize*2 < radius )
+            levelIndex++;
 
-    // Push the sample into the active list and color the pixel.
-    activeList.push_back( pos );
-    pointGrid[gy*gridSize.x + gx] = pos;
-    pointList.clear();
-    pointList.push_back( pos );
-    //cv::Vec3b color = cv::Vec3b( 255, 255, 255 );
-    //if( palette != nullptr )
-    //    color = (*palette)[1];
-    //cv::circle( image, cv::Point((int)pos.x,(int)pos.y), 2, color, 2 );
-    //image.at<uchar>( cv::Point((int)pos.x,(int)pos.y) ) = 255;
+        const GridLevel& level = levels[levelIndex];
+        int span = (int)ceil( radius / level.cellSize );
+        int gx = (int)((pos.x - domain.origin.x) / level.cellSize);
+        int gy = (int)((pos.y - domain.origin.y) / level.cellSize);
+
+        float radiusSquared = radius * radius;
+        for( int y=std::max( gy-span, 0 ); y<=std::min( gy+span, level.gridSize.y-1 ); y++ )
+        {
+            for( int x=std::max( gx-span, 0 ); x<=std::min( gx+span, level.gridSize.x-1 ); x++ )
+            {
+                for( int i=level.cellHeads[y*level.gridSize.x + x]; i!=-1; i=level.next[i] )
+                {
+                    float dx = pointList[i].x - pos.x;
+                    float dy = pointList[i].y - pos.y;
+                    if( dx*dx + dy*dy < radiusSquared )
+                        return true;
+                }
+            }
+        }
+
+        return false;
+    };
+
+    // Pick a random point.
+    float startX = stream.NextFloat( 0, pointSpaceSize.x );
+    float startY = stream.NextFloat( 0, pointSpaceSize.y );
+    addPoint( vec2( domain.origin.x + startX, domain.origin.y + startY ) );
 
     // Loop through active list.
     while( activeList.size() > 0 )
     {
         // Remove this sample from the active list.
-        vec2 currentPos = activeList[0];
+        vec2 currentPos = pointList[activeList[0]];
         activeList[0] = activeList[activeList.size()-1];
         activeList.pop_back();
 
+        // Determine the desired density around the point we're currently on.
+        float desiredDistance = minDistance;
+        if( radiusMap.empty() == false )
+        {
+            float px = (currentPos.x - domain.origin.x) * pointToPixel.x - 0.5f;
+            float py = (currentPos.y - domain.origin.y) * pointToPixel.y - 0.5f;
+            desiredDistance = SampleBilinear( radiusMap, px, py );
+        }
+
         // Check a maximum number of samples around our current position.
         for( int i=0; i<maxSamplesPerPoint; i++ )
         {
-            float angle = randFloat( 0, 2*PI );
+            float angle = stream.NextFloat( 0, 2*PI );
             vec2 dir( cos(angle), sin(angle) );
-            
-            // Determine the desired density around the pixel we're currently on.
-            float perc = 1.0f;
-            if( pointDensityImage.cols != 0 )
+            float dist = stream.NextFloat( desiredDistance, 2*desiredDistance );
+
+            vec2 pos = currentPos + dir * dist;
+
+            // Out of bounds check.
+            if( domain.Contains( pos ) == false )
             {
-                int gray = pointDensityImage.at<uchar>( cv::Point((int)currentPos.x,(int)currentPos.y) );
-                perc = gray / 255.0f;
+                continue;
             }
-            float DesiredDistance = minDistance + (maxDistance - minDistance) * perc;
 
-            float dist = randFloat( DesiredDistance, 2*DesiredDistance );
+            // If we found a spot far enough from all others, push the sample into the active list.
+            if( isTooClose( pos, desiredDistance ) == false )
+            {
+                addPoint( pos );
+            }
+        }
+    }
+}
 
-            pos = currentPos + dir * dist;
-            int ngx = (int)(pos.x / cellSize);
-            int ngy = (int)(pos.y / cellSize);
+// Low discrepancy point sets, every point is a pure function of its index so the whole set is generated in parallel.
+// R2 is Martin Roberts' additive recurrence using the plastic constant, Sobol uses the first two Sobol dimensions (a (0,2)-sequence).
+// Both are extensible, the first n points of a longer sequence are still well spread, so each layer is just a longer prefix
+//   of the same sequence and keeps all the points of the layers before it.
+// R2 gets a random toroidal shift and Sobol a random digital shift, so different seeds give different sets.
+// The jittered grid isn't extensible, so each layer is a separate finer grid.
+// If a density image is given, points are thinned, black keeps every point and white keeps 'minKeepChance' of them.
+void GenerateLowDiscrepancyPoints(std::vector<vec2>& pointList, std::vector<size_t>& layerStarts, LowDiscrepancySequence sequence, int count, float reductionRate, int numLayers, const cv::Mat* pDensityImage, float minKeepChance, const RandomStream& stream, const PointDomain& domain)
+{
+    pointList.clear();
+    layerStarts.clear();
+    layerStarts.push_back( 0 );
 
-            // Out of bounds check.
-            if( pos.x < 0 || pos.x >= pointSpaceSize.x || pos.y < 0 || pos.y >= pointSpaceSize.y ||
-                ngx < 0 || ngx >= gridSize.x || ngy < 0 || ngy >= gridSize.y )
+    if( count < 1 || numLayers < 1 )
+        return;
+
+    // Each layer multiplies the point count by reductionRate^2, same as dividing the Poisson distance by reductionRate.
+    // Layer sizes are capped to keep a bad setting from eating all the memory.
+    const size_t maxPoints = 1 << 24;
+    std::vector<size_t> layerEnds;
+    std::vector<int> gridSides;
+    {
+        double layerScale = 1.0;
+        size_t total = 0;
+        for( int layer=0; layer<numLayers; layer++ )
+        {
+            size_t end;
+            if( sequence == LowDiscrepancySequence::JitteredGrid )
             {
-                continue;
+                int side = std::max( 1, (int)round( sqrt( (double)count ) * layerScale ) );
+                gridSides.push_back( side );
+                end = total + (size_t)side * side;
+            }
+            else
+            {
+                end = std::max( total + 1, (size_t)( count * layerScale * layerScale ) );
             }
 
-            // Check all neighbouring grid cells.
-            bool tooClose = false;
-            for( int y=-halfMaxCellSpan; y<=halfMaxCellSpan; y++ )
+            if( end > maxPoints )
+                break;
+
+            layerEnds.push_back( end );
+            total = end;
+            layerScale *= reductionRate;
+        }
+
+        if( layerEnds.empty() )
+            return;
+    }
+
+    size_t totalPoints = layerEnds.back();
+    pointList.resize( totalPoints );
+
+    // Random shifts for the whole set.
+    vec2 r2Shift( stream.FloatAt( 0, 0, 0.0f, 1.0f ), stream.FloatAt( 0, 1, 0.0f, 1.0f ) );
+    uint32 sobolShiftX = stream.UIntAt( 0, 2 );
+    uint32 sobolShiftY = stream.UIntAt( 0, 3 );
+
+    // 1/g and 1/g^2 where g is the plastic constant, the unique real root of x^3 = x + 1.
+    const double g = 1.32471795724474602596;
+    const double r2StepX = 1.0 / g;
+    const double r2StepY = 1.0 / (g * g);
+
+    // Direction numbers for the second Sobol dimension, the first is the bit reversed index.
+    uint32 sobolDirections[32];
+    sobolDirections[0] = 1u << 31;
+    for( int i=1; i<32; i++ )
+        sobolDirections[i] = sobolDirections[i-1] ^ (sobolDirections[i-1] >> 1);
+
+    RandomStream jitterStream = stream.Substream( 1 );
+
+    cv::parallel_for_( cv::Range( 0, (int)totalPoints ), [&](const cv::Range& range)
+    {
+        for( int i=range.start; i<range.end; i++ )
+        {
+            size_t index = i;
+            float x, y;
+
+            if( sequence == LowDiscrepancySequence::R2 )
+            {
+                double fx = 0.5 + r2StepX * index + r2Shift.x;
+                double fy = 0.5 + r2StepY * index + r2Shift.y;
+                x = (float)(fx - floor( fx ));
+                y = (float)(fy - floor( fy ));
+            }
+            else if( sequence == LowDiscrepancySequence::Sobol )
             {
-                for( int x=-halfMaxCellSpan; x<=halfMaxCellSpan; x++ )
+                uint32 n = (uint32)index;
+                uint32 sx = 0;
+                uint32 sy = 0;
+                for( int bit=0; n != 0; bit++, n >>= 1 )
                 {
-                    ivec2 tile( ngx+x, ngy+y );
-                    int tileIndex = tile.y*gridSize.x + tile.x;
-                    if( tile.x < 0 || tile.x >= gridSize.x ) continue;
-                    if( tile.y < 0 || tile.y >= gridSize.y ) continue;
-
-                    if( pointGrid[tileIndex].x != -1 )
+                    if( n & 1 )
                     {
-                        float distance = pointGrid[tileIndex].DistanceFrom( pos );
-
-                        if( distance < DesiredDistance )
-                        {
-                            tooClose = true;
-                        }
+                        sx ^= 1u << (31 - bit);
+                        sy ^= sobolDirections[bit];
                     }
                 }
+                x = RandomStream::ToFloat01( sx ^ sobolShiftX );
+                y = RandomStream::ToFloat01( sy ^ sobolShiftY );
             }
-
-            // If we found a spot far enough from all others,
-            // push the sample into the active list and color the pixel.
-            if( tooClose == false )
+            else
             {
-                activeList.push_back( pos );
-                pointGrid[ngy*gridSize.x + ngx] = pos;
-                pointList.push_back( pos );
-                //cv::Vec3b color = cv::Vec3b( 255, 255, 255 );
-                //if( palette != nullptr )
-                //    color = (*palette)[pointList.size()];
-                //cv::circle( image, cv::Point((int)pos.x,(int)pos.y), 2, color, 2 );
-                //image.at<uchar>( cv::Point((int)pos.x,(int)pos.y) ) = 255;
+                // Find which layer's grid this point belongs to.
+                size_t layer = std::upper_bound( layerEnds.begin(), layerEnds.end(), index ) - layerEnds.begin();
+                size_t layerStart = layer == 0 ? 0 : layerEnds[layer-1];
+                int side = gridSides[layer];
+                int cellX = (int)((index - layerStart) % side);
+                int cellY = (int)((index - layerStart) / side);
+                x = (cellX + jitterStream.FloatAt( index, 0, 0.0f, 1.0f )) / side;
+                y = (cellY + jitterStream.FloatAt( index, 1, 0.0f, 1.0f )) / side;
             }
+
+            pointList[index] = domain.FromNormalized( vec2( x, y ) );
+        }
+    } );
+
+    if( pDensityImage == nullptr || pDensityImage->empty() )
+    {
+        layerStarts.insert( layerStarts.end(), layerEnds.begin(), layerEnds.end() );
+        return;
+    }
+
+    // Convert the density image into a map of keep chances.
+    cv::Mat gray = *pDensityImage;
+    if( pDensityImage->channels() == 3 )
+        cv::cvtColor( *pDensityImage, gray, cv::COLOR_BGR2GRAY );
+
+    cv::Mat keepChanceMap;
+    gray.convertTo( keepChanceMap, CV_32F, (minKeepChance - 1.0f) * GetUnitScaleForDepth( gray.depth() ), 1.0f );
+
+    std::vector<uint8> keep( totalPoints );
+    RandomStream thinningStream = stream.Substream( 2 );
+
+    cv::parallel_for_( cv::Range( 0, (int)totalPoints ), [&](const cv::Range& range)
+    {
+        for( int i=range.start; i<range.end; i++ )
+        {
+            vec2 pos = domain.ToImage( pointList[i], ivec2( keepChanceMap.cols, keepChanceMap.rows ) );
+            float keepChance = SampleBilinear( keepChanceMap, pos.x - 0.5f, pos.y - 0.5f );
+            keep[i] = thinningStream.FloatAt( i, 0, 0.0f, 1.0f ) < keepChance;
         }
+    } );
+
+    // Compact the kept points, in order, so each layer stays a contiguous range.
+    size_t numKept = 0;
+    size_t layer = 0;
+    for( size_t i=0; i<totalPoints; i++ )
+    {
+        while( i == layerEnds[layer] )
+        {
+            layerStarts.push_back( numKept );
+            layer++;
+        }
+
+        if( keep[i] )
+            pointList[numKept++] = pointList[i];
     }
+    while( layerStarts.size() < layerEnds.size() + 1 )
+        layerStarts.push_back( numKept );
+
+    pointList.resize( numKept );
 }
 
-void GenerateGrid(std::vector<vec2>& pointList, fullNeighbourList& neighbours, ivec2 gridSize, float padding, bool connectDiagonals)
+void GenerateGrid(std::vector<vec2>& pointList, fullNeighbourList& neighbours, ivec2 gridSize, float padding, bool connectDiagonals, const PointDomain& domain)
 {
     if( gridSize.x < 2 )
         gridSize.x = 2;
@@ -311,8 +1015,8 @@ void GenerateGrid(std::vector<vec2>& pointList, fullNeighbourList& neighbours, i
     pointList.resize( gridSize.x * gridSize.y );
     neighbours.resize( gridSize.x * gridSize.y );
 
-    vec2 offset = padding/2;
-    vec2 step = (100.0f - padding) / (gridSize-1);
+    vec2 offset( domain.origin.x + padding/2, domain.origin.y + padding/2 );
+    vec2 step( (domain.size.x - padding) / (gridSize.x-1), (domain.size.y - padding) / (gridSize.y-1) );
 
     //// Plot the 4 corners first.
     //pointList[0].Set( offset.x + step.x*0,              offset.y + step.y*0 ); // bl
@@ -359,8 +1063,23 @@ void GenerateGrid(std::vector<vec2>& pointList, fullNeighbourList& neighbours, i
     int indexTR = (gridSize.y-1)*gridSize.x + gridSize.x-1;
     int indexBR = gridSize.x-1;
 
-    Graph_SwapIndex( pointList, neighbours, 0, indexBL );
-    Graph_SwapIndex( pointList, neighbours, 1, indexTL );
-    Graph_SwapIndex( pointList, neighbours, 2, indexTR );
-    Graph_SwapIndex( pointList, neighbours, 3, indexBR );
+    // The swaps are done on an index list, then applied to the points and neighbours in a single pass.
+    vertIndexList order( pointList.size() );    // Old index at each new index.
+    vertIndexList newIndices( pointList.size() ); // New index of each old index.
+    for( size_t i=0; i<order.size(); i++ )
+    {
+        order[i] = i;
+        newIndices[i] = i;
+    }
+
+    int corners[4] = { indexBL, indexTL, indexTR, indexBR };
+    for( int i=0; i<4; i++ )
+    {
+        vertIndex from = newIndices[corners[i]];
+        std::swap( order[i], order[from] );
+        newIndices[order[i]] = i;
+        newIndices[order[from]] = from;
+    }
+
+    Graph_ApplyPermutation( pointList, neighbours, newIndices );
 }
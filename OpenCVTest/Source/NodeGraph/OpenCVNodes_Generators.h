@@ -10,15 +10,36 @@
 
 // OpenCV node types.
 class OpenCVNode_Generate_PoissonSampling;
+class OpenCVNode_Generate_LowDiscrepancy;
+
+enum class LowDiscrepancySequence
+{
+    R2,
+    Sobol,
+    JitteredGrid,
+    NumTypes,
+};
 
 // Implementation of Robert Bridson's "Fast Poisson Disk Sampling in Arbitrary Dimensions".
 // https://www.cs.ubc.ca/~rbridson/docs/bridson-siggraph07-poissondisk.pdf
 // Implemented solely in 2D, which probably defeats the purpose.
-void GenerateSampling(std::vector<vec2>& pointList, float minDistance, int maxSamplesPerPoint, bool startWithExistingPoints);
-void DrawSampling(cv::Mat& image, ivec2 imageSize, const std::vector<vec2>& pointList, const colorPalette* palette, const std::vector<size_t> pointListLayerStarts);
+// Points are placed inside 'domain', distances are in the domain's units.
+void GenerateSampling(std::vector<vec2>& pointList, float minDistance, int maxSamplesPerPoint, bool startWithExistingPoints, RandomStream& stream, const PointDomain& domain = PointDomain());
+// Multiple layers of the above, each layer's distance is the previous one divided by reductionRate.
+// The grid is kept between layers and only the previous layer's points are reactivated when a new layer starts.
+void GenerateLayeredSampling(std::vector<vec2>& pointList, std::vector<size_t>& layerStarts, float minDistance, float reductionRate, int numLayers, int maxSamplesPerPoint, RandomStream& stream, const PointDomain& domain = PointDomain());
+// Parallel version of GenerateSampling, fills non-adjacent tiles at the same time. Results only depend on the stream, not the thread count.
+void GenerateSamplingParallel(std::vector<vec2>& pointList, float minDistance, int maxSamplesPerPoint, bool startWithExistingPoints, const RandomStream& stream, const PointDomain& domain = PointDomain());
+// Same as the above, but each chunk of the domain gets its own small grid, for domains far larger than the minimum distance.
+// Chunks are generated in parallel and stitched together along their edges.
+void GenerateSamplingChunked(std::vector<vec2>& pointList, float minDistance, int maxSamplesPerPoint, bool startWithExistingPoints, float chunkSize, const RandomStream& stream, const PointDomain& domain = PointDomain());
+void DrawSampling(cv::Mat& image, ivec2 imageSize, const std::vector<vec2>& pointList, const colorPalette* palette, const std::vector<size_t> pointListLayerStarts, const PointDomain& domain = PointDomain());
 // Modification of the above that takes in a grayscale image that controls point density.
-void GenerateSamplingWithVaryingPointDensity(std::vector<vec2>& pointList, int maxSamplesPerPoint, cv::Mat& pointDensityImage, float minDistance, float maxDistance);
-void GenerateGrid(std::vector<vec2>& pointList, fullNeighbourList& neighbours, ivec2 gridSize, float padding, bool connectDiagonals);
+void GenerateSamplingWithVaryingPointDensity(std::vector<vec2>& pointList, int maxSamplesPerPoint, cv::Mat& pointDensityImage, float minDistance, float maxDistance, RandomStream& stream, const PointDomain& domain = PointDomain());
+// O(n) alternative to the Poisson samplers, points come from an R2 or Sobol sequence or a jittered grid and are generated in parallel.
+// Each layer has reductionRate^2 times the points of the one before it, the density image thins points out with white keeping 'minKeepChance' of them.
+void GenerateLowDiscrepancyPoints(std::vector<vec2>& pointList, std::vector<size_t>& layerStarts, LowDiscrepancySequence sequence, int count, float reductionRate, int numLayers, const cv::Mat* pDensityImage, float minKeepChance, const RandomStream& stream, const PointDomain& domain = PointDomain());
+void GenerateGrid(std::vector<vec2>& pointList, fullNeighbourList& neighbours, ivec2 gridSize, float padding, bool connectDiagonals, const PointDomain& domain = PointDomain());
 
 //====================================================================================================
 // Node_PointDistribution
@@ -26,6 +47,10 @@ void GenerateGrid(std::vector<vec2>& pointList, fullNeighbourList& neighbours, i
 
 class Node_PointDistribution : public OpenCVBaseNode
 {
+protected:
+    // Saved parameters.
+    PointDomain m_Domain;
+
 public:
     Node_PointDistribution(OpenCVNodeGraph* pNodeGraph, OpenCVNodeGraph::NodeID id, const char* name, const Vector2& pos, int inputsCount, int outputsCount)
         : OpenCVBaseNode( pNodeGraph, id, name, pos, inputsCount, outputsCount )
@@ -34,6 +59,33 @@ public:
 
     DEFINE_NODE_BASE_TYPE( "Node_PointDistribution" );
 
+    void DrawDomainControls()
+    {
+        ImGui::DragFloat2( "Domain Origin", &m_Domain.origin.x, 1.0f );
+        if( ImGui::IsItemDeactivatedAfterEdit() ) { QuickRun( false ); }
+        ImGui::DragFloat2( "Domain Size", &m_Domain.size.x, 1.0f, 1.0f, 1000000.0f );
+        if( m_Domain.size.x < 1 ) m_Domain.size.x = 1;
+        if( m_Domain.size.y < 1 ) m_Domain.size.y = 1;
+        if( ImGui::IsItemDeactivatedAfterEdit() ) { QuickRun( false ); }
+    }
+
+    virtual cJSON* ExportAsJSONObject() override
+    {
+        cJSON* jNode = OpenCVBaseNode::ExportAsJSONObject();
+        cJSONExt_AddFloatArrayToObject( jNode, "m_DomainOrigin", &m_Domain.origin.x, 2 );
+        cJSONExt_AddFloatArrayToObject( jNode, "m_DomainSize", &m_Domain.size.x, 2 );
+        return jNode;
+    }
+
+    virtual void ImportFromJSONObject(cJSON* jNode) override
+    {
+        OpenCVBaseNode::ImportFromJSONObject( jNode );
+        cJSONExt_GetFloatArray( jNode, "m_DomainOrigin", &m_Domain.origin.x, 2 );
+        cJSONExt_GetFloatArray( jNode, "m_DomainSize", &m_Domain.size.x, 2 );
+    }
+
+    virtual PointDomain GetValuePointDomain() { return m_Domain; }
+
     virtual std::vector<vec2>* GetValuePointList() = 0;
     virtual std::vector<size_t>* GetValuePointListLayerStarts() = 0;
     virtual fullNeighbourList* GetValueNeighbourList() { return nullptr; }
@@ -64,6 +116,7 @@ protected:
 
     int m_NumLayers;
     float m_SizeReductionRate;
+    bool m_Parallel;
 
 public:
     OpenCVNode_Generate_PoissonSampling(OpenCVNodeGraph* pNodeGraph, OpenCVNodeGraph::NodeID id, const char* name, const Vector2& pos)
@@ -80,6 +133,7 @@ public:
 
         m_NumLayers = 1;
         m_SizeReductionRate = 2.0f;
+        m_Parallel = false;
 
         m_DisplayColors = false;
     }
@@ -116,6 +170,9 @@ public:
         
         AdjustKnownImageWidth( m_ImageSize.x );
 
+        DrawDomainControls();
+        float maxDistance = std::max( m_Domain.size.x, m_Domain.size.y );
+
         if( ImGui::Checkbox( "Use Fixed Seed", &m_UseFixedSeed ) ) { QuickRun( false ); }
         if( m_UseFixedSeed )
         {
@@ -128,12 +185,12 @@ public:
         {
             ImGui::DragFloat( "Min Distance", &m_r_MinDistanceBetweenSamples, 1.00f, 1.00f, m_r_MaxDistanceBetweenSamples );
             if( ImGui::IsItemDeactivatedAfterEdit() ) { QuickRun( false ); }
-            ImGui::DragFloat( "Max Distance", &m_r_MaxDistanceBetweenSamples, 1.00f, m_r_MinDistanceBetweenSamples, 100.0f );
+            ImGui::DragFloat( "Max Distance", &m_r_MaxDistanceBetweenSamples, 1.00f, m_r_MinDistanceBetweenSamples, maxDistance );
             if( ImGui::IsItemDeactivatedAfterEdit() ) { QuickRun( false ); }
         }
         else
         {
-            ImGui::DragFloat( "Distance", &m_r_MinDistanceBetweenSamples, 1.0f, 1.0f, 100.0f );
+            ImGui::DragFloat( "Distance", &m_r_MinDistanceBetweenSamples, 1.0f, 1.0f, maxDistance );
             if( ImGui::IsItemDeactivatedAfterEdit() ) { QuickRun( false ); }
             m_r_MaxDistanceBetweenSamples = m_r_MinDistanceBetweenSamples;
         }
@@ -145,6 +202,10 @@ public:
         if( ImGui::IsItemDeactivatedAfterEdit() ) { QuickRun( false ); }
         ImGui::DragFloat( "Reduction", &m_SizeReductionRate, 0.1f, 1.1f, 10.0f );
         if( ImGui::IsItemDeactivatedAfterEdit() ) { QuickRun( false ); }
+        if( pDensityMask == nullptr )
+        {
+            if( ImGui::Checkbox( "Parallel", &m_Parallel ) ) { QuickRun( false ); }
+        }
 
         if( ImGui::Checkbox( "Colors", &m_DisplayColors ) ) { QuickRun( false ); }
 
@@ -175,12 +236,14 @@ public:
             pPaletteToUse = &m_pNodeGraph->GetPalette();
 
         // Generate the image.
-        if( m_UseFixedSeed )
+        uint32 nodeSeed = m_UseFixedSeed ? (uint32)m_Seed : RandomStream::NonDeterministicSeed();
+        RandomStream stream = GetRandomStream( nodeSeed );
+
+        if( pDensityMask == nullptr && m_Parallel == false )
         {
-            srand( m_Seed );
+            GenerateLayeredSampling( m_PointList, m_PointListLayerStarts, m_r_MinDistanceBetweenSamples, m_SizeReductionRate, m_NumLayers, m_k_SampleLimitBeforeRejection, stream, m_Domain );
         }
-
-        if( pDensityMask == nullptr )
+        else if( pDensityMask == nullptr )
         {
             m_PointListLayerStarts.clear();
 
@@ -193,7 +256,14 @@ public:
             {
                 layersLeft--;
 
-                GenerateSampling( m_PointList, distance, m_k_SampleLimitBeforeRejection, !firstRun );
+                // A single grid over the whole domain is faster, but once it gets too big split the domain into chunks.
+                const float maxGridCells = 16*1024*1024;
+                const float cellsPerChunk = 256;
+                float cellSize = distance / sqrtf(2);
+                if( (m_Domain.size.x / cellSize) * (m_Domain.size.y / cellSize) < maxGridCells )
+                    GenerateSamplingParallel( m_PointList, distance, m_k_SampleLimitBeforeRejection, !firstRun, stream.Substream( layersLeft ), m_Domain );
+                else
+                    GenerateSamplingChunked( m_PointList, distance, m_k_SampleLimitBeforeRejection, !firstRun, cellsPerChunk * cellSize, stream.Substream( layersLeft ), m_Domain );
                 m_PointListLayerStarts.push_back( m_PointList.size() );
                 distance /= m_SizeReductionRate;
 
@@ -202,11 +272,16 @@ public:
         }
         else
         {
-            GenerateSamplingWithVaryingPointDensity( m_PointList, m_k_SampleLimitBeforeRejection, *pDensityMask, m_r_MinDistanceBetweenSamples, m_r_MaxDistanceBetweenSamples );
+            GenerateSamplingWithVaryingPointDensity( m_PointList, m_k_SampleLimitBeforeRejection, *pDensityMask, m_r_MinDistanceBetweenSamples, m_r_MaxDistanceBetweenSamples, stream, m_Domain );
+
+            // Everything is in a single layer.
+            m_PointListLayerStarts.clear();
+            m_PointListLayerStarts.push_back( 0 );
+            m_PointListLayerStarts.push_back( m_PointList.size() );
         }
 
         m_Image = cv::Mat::zeros( cv::Size(m_ImageSize.x,m_ImageSize.y), CV_8UC3 );
-        DrawSampling( m_Image, m_ImageSize, m_PointList, pPaletteToUse, m_PointListLayerStarts );
+        DrawSampling( m_Image, m_ImageSize, m_PointList, pPaletteToUse, m_PointListLayerStarts, m_Domain );
 
         // Display it.
         m_pTexture = CreateOrUpdateTextureDefinitionFromOpenCVMat( &m_Image, m_pTexture );
@@ -230,6 +305,7 @@ public:
         cJSON_AddNumberToObject( jNode, "m_k_SampleLimitBeforeRejection", m_k_SampleLimitBeforeRejection );
         cJSON_AddNumberToObject( jNode, "m_NumLayers", m_NumLayers );
         cJSON_AddNumberToObject( jNode, "m_SizeReductionRate", m_SizeReductionRate );
+        cJSON_AddNumberToObject( jNode, "m_Parallel", m_Parallel );
         cJSON_AddNumberToObject( jNode, "m_DisplayColors", m_DisplayColors );
         return jNode;
     }
@@ -247,6 +323,7 @@ public:
         cJSONExt_GetInt( jNode, "m_k_SampleLimitBeforeRejection", &m_k_SampleLimitBeforeRejection );
         cJSONExt_GetInt( jNode, "m_NumLayers", &m_NumLayers );
         cJSONExt_GetFloat( jNode, "m_SizeReductionRate", &m_SizeReductionRate );
+        cJSONExt_GetBool( jNode, "m_Parallel", &m_Parallel );
         cJSONExt_GetBool( jNode, "m_DisplayColors", &m_DisplayColors );
     }
     
@@ -271,6 +348,231 @@ public:
     virtual float GetValueSizeReductionRate() { return m_SizeReductionRate; }
 };
 
+//====================================================================================================
+// OpenCVNode_Generate_LowDiscrepancy
+//====================================================================================================
+
+class OpenCVNode_Generate_LowDiscrepancy : public Node_PointDistribution
+{
+protected:
+    cv::Mat m_Image;
+    TextureDefinition* m_pTexture;
+    std::vector<vec2> m_PointList;
+    std::vector<size_t> m_PointListLayerStarts;
+    bool m_DisplayColors;
+
+    // Saved parameters.
+    ivec2 m_ImageSize;
+    bool m_UseFixedSeed;
+    int m_Seed;
+    LowDiscrepancySequence m_Sequence;
+    int m_NumPoints;
+    float m_MinKeepChance;
+
+    int m_NumLayers;
+    float m_SizeReductionRate;
+
+    inline static std::string SequenceNames[(int)LowDiscrepancySequence::NumTypes]
+    {
+        "R2",
+        "Sobol",
+        "Jittered Grid",
+    };
+
+public:
+    OpenCVNode_Generate_LowDiscrepancy(OpenCVNodeGraph* pNodeGraph, OpenCVNodeGraph::NodeID id, const char* name, const Vector2& pos)
+        : Node_PointDistribution( pNodeGraph, id, name, pos, 1, 1 )
+    {
+        m_pTexture = nullptr;
+
+        m_ImageSize.Set( 128, 128 );
+        m_UseFixedSeed = false;
+        m_Seed = 0;
+        m_Sequence = LowDiscrepancySequence::R2;
+        m_NumPoints = 100;
+        m_MinKeepChance = 0.1f;
+
+        m_NumLayers = 1;
+        m_SizeReductionRate = 2.0f;
+
+        m_DisplayColors = false;
+    }
+
+    ~OpenCVNode_Generate_LowDiscrepancy()
+    {
+        SAFE_RELEASE( m_pTexture );
+    }
+
+    DEFINE_NODE_TYPE( "Generate_LowDiscrepancy" );
+
+    virtual void DrawTitle() override
+    {
+        if( m_Expanded )
+            Node_PointDistribution::DrawTitle();
+        else
+            ImGui::Text( "%s", m_Name );
+    }
+
+    virtual bool DrawContents() override
+    {
+        bool modified = Node_PointDistribution::DrawContents();
+
+        cv::Mat* pDensityMask = GetInputImage( 0 );
+        if( pDensityMask )
+        {
+            m_ImageSize.Set( pDensityMask->cols, pDensityMask->rows );
+        }
+        else
+        {
+            ImGui::DragInt2( "Size", &m_ImageSize.x, 1.0f, 1, 4096 );
+            if( ImGui::IsItemDeactivatedAfterEdit() ) { QuickRun( false ); }
+        }
+
+        AdjustKnownImageWidth( m_ImageSize.x );
+
+        DrawDomainControls();
+
+        if( ImGui::BeginCombo( "Sequence", SequenceNames[(int)m_Sequence].c_str() ) )
+        {
+            for( int n = 0; n < (int)LowDiscrepancySequence::NumTypes; n++ )
+            {
+                bool is_selected = (n == (int)m_Sequence);
+                if( ImGui::Selectable( SequenceNames[n].c_str(), is_selected ) )
+                {
+                    m_Sequence = (LowDiscrepancySequence)n;
+                    QuickRun( false );
+                }
+                if( is_selected )
+                {
+                    ImGui::SetItemDefaultFocus();
+                }
+            }
+            ImGui::EndCombo();
+        }
+
+        if( ImGui::Checkbox( "Use Fixed Seed", &m_UseFixedSeed ) ) { QuickRun( false ); }
+        if( m_UseFixedSeed )
+        {
+            ImGui::SameLine();
+            ImGui::DragInt( "Seed", &m_Seed, 1.0f );
+            if( ImGui::IsItemDeactivatedAfterEdit() ) { QuickRun( false ); }
+        }
+
+        ImGui::DragInt( "# Points", &m_NumPoints, 1.0f, 1, 1000000 );
+        if( m_NumPoints < 1 )
+            m_NumPoints = 1;
+        if( ImGui::IsItemDeactivatedAfterEdit() ) { QuickRun( false ); }
+
+        if( pDensityMask )
+        {
+            ImGui::DragFloat( "Min Keep Chance", &m_MinKeepChance, 0.01f, 0.0f, 1.0f );
+            if( ImGui::IsItemDeactivatedAfterEdit() ) { QuickRun( false ); }
+        }
+
+        ImGui::DragInt( "# Layers", &m_NumLayers, 1, 1, 10 );
+        if( m_NumLayers < 1 )
+            m_NumLayers = 1;
+        if( ImGui::IsItemDeactivatedAfterEdit() ) { QuickRun( false ); }
+        ImGui::DragFloat( "Reduction", &m_SizeReductionRate, 0.1f, 1.1f, 10.0f );
+        if( ImGui::IsItemDeactivatedAfterEdit() ) { QuickRun( false ); }
+
+        if( ImGui::Checkbox( "Colors", &m_DisplayColors ) ) { QuickRun( false ); }
+
+        if( ImGui::Button( "Generate" ) )
+        {
+            Trigger( nullptr, TriggerFlags::TF_Recursive );
+        }
+
+        DisplayOpenCVMatAndTexture( &m_Image, m_pTexture, GetDisplayWidth(), m_pNodeGraph->GetHoverPixelsToShow() );
+
+        return modified;
+    }
+
+    virtual void TriggerGlobalRun() override
+    {
+        Trigger( nullptr, TriggerFlags::TF_Recursive );
+    }
+
+    virtual bool Trigger(MyEvent* pEvent, TriggerFlags triggerFlags) override
+    {
+        cv::Mat* pDensityMask = GetInputImage( 0 );
+
+        colorPalette* pPaletteToUse = nullptr;
+        if( m_DisplayColors )
+            pPaletteToUse = &m_pNodeGraph->GetPalette();
+
+        // Generate the points.
+        uint32 nodeSeed = m_UseFixedSeed ? (uint32)m_Seed : RandomStream::NonDeterministicSeed();
+        RandomStream stream = GetRandomStream( nodeSeed );
+
+        GenerateLowDiscrepancyPoints( m_PointList, m_PointListLayerStarts, m_Sequence, m_NumPoints, m_SizeReductionRate, m_NumLayers, pDensityMask, m_MinKeepChance, stream, m_Domain );
+
+        m_Image = cv::Mat::zeros( cv::Size(m_ImageSize.x,m_ImageSize.y), CV_8UC3 );
+        DrawSampling( m_Image, m_ImageSize, m_PointList, pPaletteToUse, m_PointListLayerStarts, m_Domain );
+
+        // Display it.
+        m_pTexture = CreateOrUpdateTextureDefinitionFromOpenCVMat( &m_Image, m_pTexture );
+
+        // Trigger the output nodes.
+        TriggerOutputNodes( pEvent, triggerFlags & TriggerFlags::TF_Recursive );
+
+        return false;
+    }
+
+    virtual cJSON* ExportAsJSONObject() override
+    {
+        cJSON* jNode = Node_PointDistribution::ExportAsJSONObject();
+        cJSONExt_AddIntArrayToObject( jNode, "m_ImageSize", &m_ImageSize.x, 2 );
+
+        cJSON_AddNumberToObject( jNode, "m_UseFixedSeed", m_UseFixedSeed );
+        cJSON_AddNumberToObject( jNode, "m_Seed", m_Seed );
+
+        cJSON_AddNumberToObject( jNode, "m_Sequence", (int)m_Sequence );
+        cJSON_AddNumberToObject( jNode, "m_NumPoints", m_NumPoints );
+        cJSON_AddNumberToObject( jNode, "m_MinKeepChance", m_MinKeepChance );
+        cJSON_AddNumberToObject( jNode, "m_NumLayers", m_NumLayers );
+        cJSON_AddNumberToObject( jNode, "m_SizeReductionRate", m_SizeReductionRate );
+        cJSON_AddNumberToObject( jNode, "m_DisplayColors", m_DisplayColors );
+        return jNode;
+    }
+
+    virtual void ImportFromJSONObject(cJSON* jNode) override
+    {
+        Node_PointDistribution::ImportFromJSONObject( jNode );
+        cJSONExt_GetIntArray( jNode, "m_ImageSize", &m_ImageSize.x, 2 );
+
+        cJSONExt_GetBool( jNode, "m_UseFixedSeed", &m_UseFixedSeed );
+        cJSONExt_GetInt( jNode, "m_Seed", &m_Seed );
+
+        cJSONExt_GetInt( jNode, "m_Sequence", (int*)&m_Sequence );
+        cJSONExt_GetInt( jNode, "m_NumPoints", &m_NumPoints );
+        cJSONExt_GetFloat( jNode, "m_MinKeepChance", &m_MinKeepChance );
+        cJSONExt_GetInt( jNode, "m_NumLayers", &m_NumLayers );
+        cJSONExt_GetFloat( jNode, "m_SizeReductionRate", &m_SizeReductionRate );
+        cJSONExt_GetBool( jNode, "m_DisplayColors", &m_DisplayColors );
+    }
+
+    virtual std::string GetSettingsString() override
+    {
+        std::string settingsString;
+        settingsString += "-fs" + std::to_string( m_UseFixedSeed );
+        settingsString += "-s" + std::to_string( m_Seed );
+        settingsString += "-" + SequenceNames[(int)m_Sequence];
+        settingsString += "-n" + std::to_string( m_NumPoints );
+        settingsString += "-nl" + std::to_string( m_NumLayers );
+        settingsString += "-rr"; PrintFloatBadlyWithPrecision( settingsString, m_SizeReductionRate, 2 );
+
+        return settingsString;
+    }
+
+    virtual cv::Mat* GetValueMat() override { return &m_Image; }
+    virtual std::vector<vec2>* GetValuePointList() override { return &m_PointList; }
+    virtual std::vector<size_t>* GetValuePointListLayerStarts() { return &m_PointListLayerStarts; }
+    // Roughly the Poisson distance that would give the same number of points in the first layer.
+    virtual float GetValueR_MinDistance() { return 0.75f * sqrtf( m_Domain.size.x * m_Domain.size.y / m_NumPoints ); }
+    virtual float GetValueSizeReductionRate() { return m_SizeReductionRate; }
+};
+
 //====================================================================================================
 // OpenCVNode_Generate_RegularGrid
 //====================================================================================================
@@ -341,6 +643,8 @@ public:
 
         AdjustKnownImageWidth( m_ImageSize.x );
 
+        DrawDomainControls();
+
         ImGui::DragInt2( "Grid Size", &m_GridSize.x, 1.00f, 1, 100 );
         if( ImGui::IsItemDeactivatedAfterEdit() ) { QuickRun( false ); }
 
@@ -386,14 +690,16 @@ public:
             m_PointListLayerStarts.clear();
             m_PointListLayerStarts.push_back( 0 );
 
-            GenerateGrid( m_PointList, m_NeighbourList, m_GridSize, 20, m_ConnectDiagonals );
+            // Same 20% padding the grid always had in the 0 to 100 space.
+            float padding = std::min( m_Domain.size.x, m_Domain.size.y ) * 0.2f;
+            GenerateGrid( m_PointList, m_NeighbourList, m_GridSize, padding, m_ConnectDiagonals, m_Domain );
             m_PointListLayerStarts.push_back( 4 );
             m_PointListLayerStarts.push_back( 4 );
             m_PointListLayerStarts.push_back( m_PointList.size() );
         }
 
         m_Image = cv::Mat::zeros( cv::Size(m_ImageSize.x,m_ImageSize.y), CV_8UC3 );
-        DrawSampling( m_Image, m_ImageSize, m_PointList, pPaletteToUse, m_PointListLayerStarts );
+        DrawSampling( m_Image, m_ImageSize, m_PointList, pPaletteToUse, m_PointListLayerStarts, m_Domain );
 
         // Display it.
         m_pTexture = CreateOrUpdateTextureDefinitionFromOpenCVMat( &m_Image, m_pTexture );
@@ -447,7 +753,7 @@ public:
     virtual std::vector<size_t>* GetValuePointListLayerStarts() { return &m_PointListLayerStarts; }
     virtual fullNeighbourList* GetValueNeighbourList() { return &m_NeighbourList; }
     virtual float GetValueSizeReductionRate() { return m_SizeReductionRate; }
-    virtual float GetValueR_MinDistance() { return 100; }
+    virtual float GetValueR_MinDistance() { return std::max( m_Domain.size.x, m_Domain.size.y ); }
 };
 
 #endif //__OpenCVNodes_Generators_H__
@@ -4,6 +4,7 @@
 #include "OpenCVPCH.h"
 #include "OpenCVNodes_Noise.h"
 #include "Graph/GraphHelpers.h"
+#include "Utility/SimplexNoise.h"
 
 OpenCVNode_Generate_SimplexNoise::OpenCVNode_Generate_SimplexNoise(OpenCVNodeGraph* pNodeGraph, OpenCVNodeGraph::NodeID id, const char* name, const Vector2& pos)
     : OpenCVBaseNode( pNodeGraph, id, name, pos, 0, 1 )
@@ -17,48 +18,167 @@ OpenCVNode_Generate_SimplexNoise::~OpenCVNode_Generate_SimplexNoise()
 
 void OpenCVNode_Generate_SimplexNoise::GenerateNoise()
 {
-    osn_context* noiseContext;
-    open_simplex_noise( m_Seed, &noiseContext );
+    uint32 nodeSeed = m_UseFixedSeed ? (uint32)m_Seed : RandomStream::NonDeterministicSeed();
+
+    SimplexNoise2D noise( GetRandomStream( nodeSeed, 1 ) );
+
+    // Work out the settings for each octave once, rather than per pixel.
+    // Each octave after the first is shifted by a random offset.
+    const float persistance = 0.08f; //m_Persistance;
+    const float lacunarity = 5.0f; //m_Lacunarity;
+
+    RandomStream stream = GetRandomStream( nodeSeed );
+    m_OctaveOffsets.assign( m_NumOctaves, m_Offset );
+    m_OctaveFrequencies.resize( m_NumOctaves );
+    m_OctaveAmplitudes.resize( m_NumOctaves );
+    float freq = m_Frequency;
+    float amplitude = 1.0f; //m_Amplitude;
+    for( int octave = 0; octave < m_NumOctaves; octave++ )
+    {
+        if( octave > 0 )
+        {
+            m_OctaveOffsets[octave] += vec2( stream.FloatAt( octave, 0, 0, 10000 ), stream.FloatAt( octave, 1, 0, 10000 ) );
+        }
+
+        m_OctaveFrequencies[octave] = freq;
+        m_OctaveAmplitudes[octave] = amplitude;
+        amplitude *= persistance;
+        freq *= lacunarity;
+    }
+
+    m_RawNoise.create( cv::Size(m_ImageSize.x,m_ImageSize.y), CV_32F );
+
+    if( m_Tiled == false )
+    {
+        GenerateRawNoise( noise, m_RawNoise, m_WindowOrigin );
+        return;
+    }
 
-    cv::Vec3b* imageValues = (cv::Vec3b*)m_Image.ptr();
-    uint32 imageStride = (uint32)( m_Image.step[0]/m_Image.channels() );
+    if( m_TileSize < 16 )
+        m_TileSize = 16;
 
-    for( int y = 0; y < m_ImageSize.y; y++ )
+    // Drop the cached tiles if anything that affects them has changed.
+    std::string settings = std::to_string( m_pNodeGraph->GetSeed() ) + "," + std::to_string( nodeSeed ) + "," +
+                           std::to_string( m_NumOctaves ) + "," + std::to_string( m_Frequency ) + "," +
+                           std::to_string( m_Offset.x ) + "," + std::to_string( m_Offset.y ) + "," + std::to_string( m_TileSize );
+    if( settings != m_TileCacheSettings )
     {
-        for( int x = 0; x < m_ImageSize.x; x++ )
+        ClearTileCache();
+        m_TileCacheSettings = settings;
+    }
+
+    // Copy the window out of the tiles it overlaps, generating any that aren't cached.
+    auto floorDivide = [](int value, int divisor) { return value >= 0 ? value / divisor : -((-value + divisor - 1) / divisor); };
+    ivec2 windowEnd( m_WindowOrigin.x + m_ImageSize.x, m_WindowOrigin.y + m_ImageSize.y );
+    int firstTileX = floorDivide( m_WindowOrigin.x, m_TileSize );
+    int firstTileY = floorDivide( m_WindowOrigin.y, m_TileSize );
+
+    for( int ty = firstTileY; ty*m_TileSize < windowEnd.y; ty++ )
+    {
+        for( int tx = firstTileX; tx*m_TileSize < windowEnd.x; tx++ )
         {
-            vec2 offset = m_Offset;
-            float freq = m_Frequency;
-            float amplitude = 1.0f; //m_Amplitude;
-            float persistance = 0.08f; //m_Persistance;
-            float lacunarity = 5.0f; //m_Lacunarity;
-
-            float totalNoise = 0;
-            for( int octave = 0; octave < m_NumOctaves; octave++ )
-            {
-                vec2 pos = vec2((float)x,(float)y) * freq + offset;
+            const cv::Mat& tile = GetTile( noise, ivec2( tx, ty ) );
 
-                float noise = (float)open_simplex_noise2( noiseContext, pos.x, pos.y );
+            cv::Rect tileRect( tx*m_TileSize, ty*m_TileSize, m_TileSize, m_TileSize );
+            cv::Rect windowRect( m_WindowOrigin.x, m_WindowOrigin.y, m_ImageSize.x, m_ImageSize.y );
+            cv::Rect overlap = tileRect & windowRect;
 
-                totalNoise += noise * amplitude;
-                amplitude *= persistance;
-                freq *= lacunarity;
+            tile( overlap - tileRect.tl() ).copyTo( m_RawNoise( overlap - windowRect.tl() ) );
+        }
+    }
+}
 
-                offset.Set( fw::Random::Float(0,10000), fw::Random::Float(0,10000) );
+void OpenCVNode_Generate_SimplexNoise::GenerateRawNoise(const SimplexNoise2D& noise, cv::Mat& output, ivec2 worldOrigin)
+{
+    // Rows are split across threads, each pixel is computed the same way no matter which thread runs it.
+    // Coordinates are converted to float before scaling, so precision drops for windows millions of pixels from the origin.
+    int width = output.cols;
+    cv::parallel_for_( cv::Range( 0, output.rows ), [&](const cv::Range& range)
+    {
+        std::vector<float> octaveNoise( width );
+
+        for( int y = range.start; y < range.end; y++ )
+        {
+            float* totalNoise = output.ptr<float>( y );
+            std::fill( totalNoise, totalNoise + width, 0.0f );
+
+            for( int octave = 0; octave < (int)m_OctaveFrequencies.size(); octave++ )
+            {
+                float noiseY = (float)(worldOrigin.y + y) * m_OctaveFrequencies[octave] + m_OctaveOffsets[octave].y;
+                noise.NoiseRow( worldOrigin.x, width, m_OctaveFrequencies[octave], m_OctaveOffsets[octave].x, noiseY, octaveNoise.data() );
+
+                float octaveAmplitude = m_OctaveAmplitudes[octave];
+                for( int x = 0; x < width; x++ )
+                {
+                    totalNoise[x] += octaveNoise[x] * octaveAmplitude;
+                }
             }
-            
-            totalNoise = totalNoise * 0.5f + 0.5f;
+        }
+    } );
+}
 
-            uchar noiseChar = (uchar)( totalNoise * 255 );
+const cv::Mat& OpenCVNode_Generate_SimplexNoise::GetTile(const SimplexNoise2D& noise, ivec2 tileCoord)
+{
+    std::pair<int, int> key( tileCoord.x, tileCoord.y );
 
-            if( m_Inverse )
-                noiseChar = 255 - noiseChar;
+    auto it = m_TileLookup.find( key );
+    if( it != m_TileLookup.end() )
+    {
+        // Move it to the front of the list.
+        m_TileCache.splice( m_TileCache.begin(), m_TileCache, it->second );
+        return it->second->rawNoise;
+    }
 
-            imageValues[y*imageStride + x] = cv::Vec3b( noiseChar, noiseChar, noiseChar );
-        }
+    // Make room by dropping the least recently used tile.
+    if( (int)m_TileCache.size() >= std::max( m_MaxCachedTiles, 1 ) )
+    {
+        const CachedTile& oldest = m_TileCache.back();
+        m_TileLookup.erase( std::pair<int, int>( oldest.coord.x, oldest.coord.y ) );
+        m_TileCache.pop_back();
     }
 
-    open_simplex_noise_free( noiseContext );
+    CachedTile tile;
+    tile.coord = tileCoord;
+    tile.rawNoise.create( m_TileSize, m_TileSize, CV_32F );
+    GenerateRawNoise( noise, tile.rawNoise, ivec2( tileCoord.x*m_TileSize, tileCoord.y*m_TileSize ) );
+
+    m_TileCache.push_front( tile );
+    m_TileLookup[key] = m_TileCache.begin();
+
+    return m_TileCache.front().rawNoise;
+}
+
+void OpenCVNode_Generate_SimplexNoise::ClearTileCache()
+{
+    m_TileCache.clear();
+    m_TileLookup.clear();
+}
+
+void OpenCVNode_Generate_SimplexNoise::ConvertRawNoiseToOutput()
+{
+    // Map from roughly -1 to 1 into 0 to 1, flipped if needed.
+    float scale = m_Inverse ? -0.5f : 0.5f;
+
+    switch( m_OutputFormat )
+    {
+    case OutputFormat::Float32:
+        m_RawNoise.convertTo( m_Image, CV_32F, scale, 0.5f );
+        m_Image = cv::min( cv::max( m_Image, 0.0 ), 1.0 );
+        break;
+
+    case OutputFormat::UInt16:
+        m_RawNoise.convertTo( m_Image, CV_16U, scale * 65535, 0.5f * 65535 );
+        break;
+
+    case OutputFormat::Gray8UC3:
+    default:
+        {
+            cv::Mat gray;
+            m_RawNoise.convertTo( gray, CV_8U, scale * 255, 0.5f * 255 );
+            cv::cvtColor( gray, m_Image, cv::COLOR_GRAY2BGR );
+        }
+        break;
+    }
 }
 
 void OpenCVNode_Generate_SimplexNoise::DrawTitle()
@@ -99,6 +219,35 @@ bool OpenCVNode_Generate_SimplexNoise::DrawContents()
     if( ImGui::DragFloat2( "Offset", &m_Offset.x, 0.1f, 0.0f, 1000.0f ) ) { QuickRun( false ); }
     if( ImGui::Checkbox( "Inverse", &m_Inverse ) ) { QuickRun( false ); }
 
+    if( ImGui::BeginCombo( "Format", OutputFormatNames[(int)m_OutputFormat].c_str() ) )
+    {
+        for( int n = 0; n < (int)OutputFormat::NumTypes; n++ )
+        {
+            bool is_selected = (n == (int)m_OutputFormat);
+            if( ImGui::Selectable( OutputFormatNames[n].c_str(), is_selected ) )
+            {
+                m_OutputFormat = (OutputFormat)n;
+                QuickRun( false );
+            }
+            if( is_selected )
+            {
+                ImGui::SetItemDefaultFocus();
+            }
+        }
+        ImGui::EndCombo();
+    }
+
+    ImGui::DragInt2( "Origin", &m_WindowOrigin.x, 1.0f );
+    if( ImGui::IsItemDeactivatedAfterEdit() ) { QuickRun( false ); }
+    if( ImGui::Checkbox( "Tiled", &m_Tiled ) ) { QuickRun( false ); }
+    if( m_Tiled )
+    {
+        ImGui::DragInt( "Tile Size", &m_TileSize, 1.0f, 16, 4096 );
+        if( ImGui::IsItemDeactivatedAfterEdit() ) { QuickRun( false ); }
+        ImGui::DragInt( "Max Tiles", &m_MaxCachedTiles, 1.0f, 1, 4096 );
+        ImGui::Text( "Cached tiles: %d", (int)m_TileCache.size() );
+    }
+
     if( ImGui::Button( "Generate" ) )
     {
         Trigger( nullptr, TriggerFlags::TF_Recursive );
@@ -120,16 +269,9 @@ bool OpenCVNode_Generate_SimplexNoise::Trigger(MyEvent* pEvent, TriggerFlags tri
 
     cv::Mat* pDensityMask = GetInputImage( 0 );
 
-    // Generate the image.
-    if( m_UseFixedSeed )
-    {
-        srand( m_Seed );
-    }
-
-    m_Image = cv::Mat::zeros( cv::Size(m_ImageSize.x,m_ImageSize.y), CV_8UC3 );
-
     // Generate noise.
     GenerateNoise();
+    ConvertRawNoiseToOutput();
 
     // Display it.
     m_pTexture = CreateOrUpdateTextureDefinitionFromOpenCVMat( &m_Image, m_pTexture );
@@ -152,6 +294,12 @@ cJSON* OpenCVNode_Generate_SimplexNoise::ExportAsJSONObject()
     cJSON_AddNumberToObject( jNode, "m_Frequency", m_Frequency );
     cJSONExt_AddFloatArrayToObject( jNode, "m_Offset", &m_Offset.x, 2 );
     cJSON_AddNumberToObject( jNode, "m_Inverse", m_Inverse );
+
+    cJSON_AddNumberToObject( jNode, "m_OutputFormat", (int)m_OutputFormat );
+    cJSONExt_AddIntArrayToObject( jNode, "m_WindowOrigin", &m_WindowOrigin.x, 2 );
+    cJSON_AddNumberToObject( jNode, "m_Tiled", m_Tiled );
+    cJSON_AddNumberToObject( jNode, "m_TileSize", m_TileSize );
+    cJSON_AddNumberToObject( jNode, "m_MaxCachedTiles", m_MaxCachedTiles );
     return jNode;
 }
 
@@ -167,6 +315,12 @@ void OpenCVNode_Generate_SimplexNoise::ImportFromJSONObject(cJSON* jNode)
     cJSONExt_GetFloat( jNode, "m_Frequency", m_Frequency );
     cJSONExt_GetFloatArray( jNode, "m_Offset", &m_Offset.x, 2 );
     cJSONExt_GetBool( jNode, "m_Inverse", m_Inverse );
+
+    cJSONExt_GetInt( jNode, "m_OutputFormat", (int*)&m_OutputFormat );
+    cJSONExt_GetIntArray( jNode, "m_WindowOrigin", &m_WindowOrigin.x, 2 );
+    cJSONExt_GetBool( jNode, "m_Tiled", &m_Tiled );
+    cJSONExt_GetInt( jNode, "m_TileSize", &m_TileSize );
+    cJSONExt_GetInt( jNode, "m_MaxCachedTiles", &m_MaxCachedTiles );
 }
 
 std::string OpenCVNode_Generate_SimplexNoise::GetSettingsString()
@@ -7,6 +7,9 @@
 #include "OpenCVNodes_Base.h"
 #include "Utility/Helpers.h"
 #include "Graph/GraphTypes.h"
+#include <list>
+
+class SimplexNoise2D;
 
 // OpenCV node types.
 class OpenCVNode_Generate_SimplexNoise;
@@ -17,10 +20,44 @@ class OpenCVNode_Generate_SimplexNoise;
 
 class OpenCVNode_Generate_SimplexNoise : public OpenCVBaseNode
 {
+public:
+    enum class OutputFormat
+    {
+        Gray8UC3,
+        Float32,
+        UInt16,
+        NumTypes,
+    };
+
+    inline static std::string OutputFormatNames[(int)OutputFormat::NumTypes]
+    {
+        "8 bit, 3 channel",
+        "32 bit float",
+        "16 bit",
+    };
+
 protected:
     cv::Mat m_Image;
     TextureDefinition* m_pTexture = nullptr;
 
+    // Summed octaves for the current window, before conversion to the output format. Roughly -1 to 1.
+    cv::Mat m_RawNoise;
+
+    // Per run octave settings.
+    std::vector<vec2> m_OctaveOffsets;
+    std::vector<float> m_OctaveFrequencies;
+    std::vector<float> m_OctaveAmplitudes;
+
+    // Tiled mode keeps raw noise tiles in world pixel coordinates, the least recently used tiles are dropped first.
+    struct CachedTile
+    {
+        ivec2 coord;
+        cv::Mat rawNoise;
+    };
+    std::list<CachedTile> m_TileCache; // Most recently used at the front.
+    std::map<std::pair<int, int>, std::list<CachedTile>::iterator> m_TileLookup;
+    std::string m_TileCacheSettings; // Settings the cached tiles were generated with.
+
     // Saved parameters.
     ivec2 m_ImageSize = ivec2( 512, 512 );
     bool m_UseFixedSeed = true;
@@ -31,6 +68,12 @@ protected:
     vec2 m_Offset = vec2( 0.0f, 0.0f );
     bool m_Inverse = false;
 
+    OutputFormat m_OutputFormat = OutputFormat::Gray8UC3;
+    ivec2 m_WindowOrigin = ivec2( 0, 0 ); // World pixel coordinates of the top left of the output.
+    bool m_Tiled = false;
+    int m_TileSize = 256;
+    int m_MaxCachedTiles = 64;
+
 public:
     OpenCVNode_Generate_SimplexNoise(OpenCVNodeGraph* pNodeGraph, OpenCVNodeGraph::NodeID id, const char* name, const Vector2& pos);
     ~OpenCVNode_Generate_SimplexNoise();
@@ -38,6 +81,10 @@ public:
     DEFINE_NODE_TYPE( "Generate_SimplexNoise" );
 
     void GenerateNoise();
+    void GenerateRawNoise(const SimplexNoise2D& noise, cv::Mat& output, ivec2 worldOrigin);
+    const cv::Mat& GetTile(const SimplexNoise2D& noise, ivec2 tileCoord);
+    void ClearTileCache();
+    void ConvertRawNoiseToOutput();
 
     virtual void DrawTitle() override;
     virtual bool DrawContents() override;
@@ -8,18 +8,6 @@
 
 using namespace cv;
 
-float randFloat(float min, float max)
-{
-    float r01 = rand()/(float)RAND_MAX;
-    return min + (max - min) * r01;
-}
-
-size_t randSizeT(size_t min, size_t max)
-{
-    float r01 = rand()/(float)RAND_MAX;
-    return min + (int)round((max - min) * r01);
-}
-
 void ShowImageWithFixedWidthAtPosition(const cv::String windowName, cv::Mat& image, int width, int posX, int posY)
 {
     int displayWidth = width;
@@ -66,6 +54,105 @@ void ShowDFTResult(const cv::String windowName, cv::Mat& image, int width, int p
     ShowImageWithFixedWidthAtPosition( windowName, magnitudeOfDFT, width, posX, posY );
 }
 
+int GetOptimalEvenDFTSize(int size)
+{
+    // Keep sizes even so packed (CCS) spectrums always have the same layout.
+    size = getOptimalDFTSize( size );
+    while( size & 1 )
+        size = getOptimalDFTSize( size + 1 );
+
+    return size;
+}
+
+// Unpack a real-input DFT stored in OpenCV's packed CCS format (even sizes only)
+//   into a full size, log scaled and normalized magnitude image with the origin in the center.
+void GetLogMagnitudeFromPackedDFT(const cv::Mat& packed, cv::Mat& output)
+{
+    assert( packed.type() == CV_32F && (packed.rows & 1) == 0 && (packed.cols & 1) == 0 );
+
+    int rows = packed.rows;
+    int cols = packed.cols;
+    output.create( rows, cols, CV_32F );
+
+    // Columns 0 and N/2 are stored down the first and last columns as 1D packed spectrums.
+    for( int c=0; c<2; c++ )
+    {
+        int srcCol = c == 0 ? 0 : cols-1;
+        int dstCol = c == 0 ? 0 : cols/2;
+
+        output.at<float>( 0, dstCol ) = fabsf( packed.at<float>( 0, srcCol ) );
+        output.at<float>( rows/2, dstCol ) = fabsf( packed.at<float>( rows-1, srcCol ) );
+        for( int r=1; r<rows/2; r++ )
+        {
+            float m = sqrtf( packed.at<float>( 2*r-1, srcCol ) * packed.at<float>( 2*r-1, srcCol ) +
+                             packed.at<float>( 2*r, srcCol ) * packed.at<float>( 2*r, srcCol ) );
+            output.at<float>( r, dstCol ) = m;
+            output.at<float>( rows-r, dstCol ) = m;
+        }
+    }
+
+    // The rest of the left half is stored as Re/Im pairs, the right half is its conjugate mirror.
+    for( int r=0; r<rows; r++ )
+    {
+        const float* pSrc = packed.ptr<float>( r );
+        float* pDest = output.ptr<float>( r );
+        float* pMirror = output.ptr<float>( (rows - r) % rows );
+        for( int k=1; k<cols/2; k++ )
+        {
+            float m = sqrtf( pSrc[2*k-1]*pSrc[2*k-1] + pSrc[2*k]*pSrc[2*k] );
+            pDest[k] = m;
+            pMirror[cols-k] = m;
+        }
+    }
+
+    output += Scalar::all(1);
+    log( output, output );
+    normalize( output, output, 0, 1, NORM_MINMAX );
+
+    ShiftTopLeftToCenter( output );
+}
+
+void BuildImagePyramid(const cv::Mat& image, std::vector<cv::Mat>& levels, int maxLevels, bool gaussian, int minSize)
+{
+    // Don't clear the vector, existing levels get reused if they're already the right size.
+    int numLevels = 1;
+    cv::Size size = image.size();
+    while( numLevels < maxLevels && size.width/2 >= minSize && size.height/2 >= minSize )
+    {
+        size = cv::Size( (size.width + 1)/2, (size.height + 1)/2 );
+        numLevels++;
+    }
+
+    levels.resize( numLevels );
+    levels[0] = image;
+
+    // Each level depends on the previous one, so levels are built in order.
+    for( int i=1; i<numLevels; i++ )
+    {
+        const cv::Mat& source = levels[i-1];
+        cv::Size halfSize( (source.cols + 1)/2, (source.rows + 1)/2 );
+
+        if( gaussian )
+            cv::pyrDown( source, levels[i], halfSize );
+        else
+            cv::resize( source, levels[i], halfSize, 0, 0, cv::INTER_AREA );
+    }
+}
+
+// Returns the index of the smallest level that's at least minWidth wide, or 0 if none are.
+int PickPyramidLevel(const std::vector<cv::Mat>& levels, int minWidth)
+{
+    int level = 0;
+    for( int i=1; i<(int)levels.size(); i++ )
+    {
+        if( levels[i].cols < minWidth )
+            break;
+        level = i;
+    }
+
+    return level;
+}
+
 void ShiftTopLeftToCenter(cv::Mat& image)
 {
     // Rearrange the quadrants of the image so that the origin is at the center.
@@ -102,6 +189,20 @@ uint32 NextPowerOfTwo(int value)
     return power;
 }
 
+// Multiplier that maps an image's full range to 0 to 1. Float images are assumed to already be in 0 to 1.
+double GetUnitScaleForDepth(int depth)
+{
+    switch( depth )
+    {
+    case CV_8U:  return 1.0 / 255.0;
+    case CV_8S:  return 1.0 / 127.0;
+    case CV_16U: return 1.0 / 65535.0;
+    case CV_16S: return 1.0 / 32767.0;
+    case CV_32S: return 1.0 / 2147483647.0;
+    default:     return 1.0;
+    }
+}
+
 // From https://gist.github.com/zhangzhensong/03f67947c22acb5ee922
 void BindCVMat2GLTexture(cv::Mat& image, GLuint& imageTexture, uint32* w, uint32* h)
 {
@@ -153,6 +254,12 @@ void BindCVMat2GLTexture(cv::Mat& image, GLuint& imageTexture, uint32* w, uint32
             // Convert from gray to RGB.
             cv::cvtColor( temp, temp, COLOR_GRAY2RGB );
         }
+        else if( type == CV_16U )
+        {
+            // Drop to 8 bits and convert from gray to RGB.
+            temp.convertTo( temp, CV_8U, 1.0/257.0 );
+            cv::cvtColor( temp, temp, COLOR_GRAY2RGB );
+        }
         else
         {
         }
@@ -263,6 +370,11 @@ void DisplayOpenCVMatAndTexture(cv::Mat* pImage, TextureDefinition* pTexture, in
                 float value = pImage->at<float>( (int)regionCenterNative.y, (int)regionCenterNative.x );
                 ImGui::Text( "(%d,%d) %f", (int)regionCenterNative.x, (int)regionCenterNative.y, value );
             }
+            else if( type == CV_16U )
+            {
+                ushort value = pImage->at<ushort>( (int)regionCenterNative.y, (int)regionCenterNative.x );
+                ImGui::Text( "(%d,%d) %d", (int)regionCenterNative.x, (int)regionCenterNative.y, value );
+            }
             else
             {
                 uint8 intensity = pImage->at<uchar>( (int)regionCenterNative.y, (int)regionCenterNative.x );
@@ -325,14 +437,31 @@ std::vector<cv::Vec3b> GeneratePalette()
     palette.push_back( cv::Vec3b( 0, 255, 255 ) );
     palette.push_back( cv::Vec3b( 255, 255, 255 ) );
 
+    // Same colors every run.
+    RandomStream stream( 0 );
     for( int i=0; i<1000; i++ )
     {
-        palette.push_back( cv::Vec3b( rand()%255, rand()%255, rand()%255 ) );
+        palette.push_back( cv::Vec3b( stream.UIntAt( i, 0 )%255, stream.UIntAt( i, 1 )%255, stream.UIntAt( i, 2 )%255 ) );
     }
 
     return palette;
 }
 
+cv::CascadeClassifier* GetCachedCascadeClassifier(const std::string& filename)
+{
+    thread_local std::map<std::string, cv::CascadeClassifier> cache;
+
+    cv::CascadeClassifier& classifier = cache[filename];
+    if( classifier.empty() )
+    {
+        // Try again if a previous load failed, the file might have been copied in since.
+        if( classifier.load( filename ) == false )
+            return nullptr;
+    }
+
+    return &classifier;
+}
+
 cv::Vec3f AsVec3f(Vector3 v)
 {
     return cv::Vec3f( v.x, v.y, v.z );
@@ -5,18 +5,24 @@
 #define __Helpers_H__
 
 #include "opencv2/opencv.hpp"
-
-float randFloat(float min, float max);
-size_t randSizeT(size_t min, size_t max);
+#include "RandomStream.h"
 
 void ShowImageWithFixedWidthAtPosition(const cv::String windowName, cv::Mat& image, int width, int posX, int posY);
 
 void GenerateDFTFromGrayscaleImage(cv::Mat& image, cv::Mat& output);
 void ShowDFTResult(const cv::String windowName, cv::Mat& image, int width, int posX, int posY);
+int GetOptimalEvenDFTSize(int size);
+void GetLogMagnitudeFromPackedDFT(const cv::Mat& packed, cv::Mat& output);
 
 void ShiftTopLeftToCenter(cv::Mat& image);
 
+// Level 0 is a header pointing at the source image, each level after that is half the size of the one before it.
+// Levels are built with pyrDown (Gaussian) or INTER_AREA resizing, both already run in parallel and with SIMD inside OpenCV.
+void BuildImagePyramid(const cv::Mat& image, std::vector<cv::Mat>& levels, int maxLevels, bool gaussian, int minSize = 16);
+int PickPyramidLevel(const std::vector<cv::Mat>& levels, int minWidth);
+
 uint32 NextPowerOfTwo(int value);
+double GetUnitScaleForDepth(int depth);
 
 void BindCVMat2GLTexture(cv::Mat& image, GLuint& imageTexture, uint32* w, uint32* h);
 void CopyFBOToCVMat(FBODefinition* pFBO, cv::Mat& dest, bool bindFBO);
@@ -31,6 +37,10 @@ void PrintFloatBadlyWithPrecision(std::string& str, float value, int maxDecimalP
 typedef std::vector<cv::Vec3b> colorPalette;
 std::vector<cv::Vec3b> GeneratePalette();
 
+// Haar cascades are parsed once per thread and shared by every node that asks for the same file.
+// cv::CascadeClassifier keeps scratch buffers inside detectMultiScale, so instances can't be shared across threads.
+cv::CascadeClassifier* GetCachedCascadeClassifier(const std::string& filename);
+
 cv::Vec3f AsVec3f(Vector3 v);
 cv::Vec3b AsVec3b(Vector3 v);
 Vector3 AsVec3(cv::Vec3f v);
@@ -0,0 +1,150 @@
+//
+// Copyright (c) 2022 Jimmy Lord
+//
+#ifndef __RandomStream_H__
+#define __RandomStream_H__
+
+#include <random>
+
+// Counter based random numbers using Philox4x32-10.
+// https://www.thesalmons.org/john/random123/papers/random123sc11.pdf
+// There's no hidden state shared between streams, every value is a pure function of the stream key and a counter.
+// Values can be drawn in sequence with the Next* functions, or by item index with the *At functions,
+//   so work split across threads can pull the same numbers for an item regardless of which thread runs it.
+class RandomStream
+{
+protected:
+    uint32 m_Key[2];
+
+    // Sequential draws walk through blocks of 4 values.
+    uint64 m_NextBlock;
+    uint32 m_Block[4];
+    uint32 m_NextInBlock;
+
+protected:
+    static inline uint32 MulHiLo(uint32 a, uint32 b, uint32* pHi)
+    {
+        uint64 product = (uint64)a * b;
+        *pHi = (uint32)(product >> 32);
+        return (uint32)product;
+    }
+
+    static inline uint64 Mix64(uint64 value)
+    {
+        // SplitMix64 finalizer, used only to turn seeds into keys.
+        value += 0x9E3779B97F4A7C15ull;
+        value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+        value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+        return value ^ (value >> 31);
+    }
+
+    static void Philox4x32_10(const uint32 counter[4], const uint32 key[2], uint32 out[4])
+    {
+        uint32 c0 = counter[0], c1 = counter[1], c2 = counter[2], c3 = counter[3];
+        uint32 k0 = key[0], k1 = key[1];
+
+        for( int round=0; round<10; round++ )
+        {
+            uint32 hi0, hi1;
+            uint32 lo0 = MulHiLo( 0xD2511F53, c0, &hi0 );
+            uint32 lo1 = MulHiLo( 0xCD9E8D57, c2, &hi1 );
+
+            c0 = hi1 ^ c1 ^ k0;
+            c1 = lo1;
+            c2 = hi0 ^ c3 ^ k1;
+            c3 = lo0;
+
+            k0 += 0x9E3779B9;
+            k1 += 0xBB67AE85;
+        }
+
+        out[0] = c0; out[1] = c1; out[2] = c2; out[3] = c3;
+    }
+
+    void SetKey(uint64 key)
+    {
+        m_Key[0] = (uint32)key;
+        m_Key[1] = (uint32)(key >> 32);
+        m_NextBlock = 0;
+        m_NextInBlock = 4;
+    }
+
+public:
+    // Streams are keyed by a graph wide seed, the node asking for numbers, what they're for and the node's own seed.
+    RandomStream(uint32 graphSeed, uint32 nodeID = 0, uint32 purpose = 0, uint32 nodeSeed = 0)
+    {
+        uint64 key = Mix64( graphSeed );
+        key = Mix64( key ^ nodeID );
+        key = Mix64( key ^ purpose );
+        key = Mix64( key ^ nodeSeed );
+        SetKey( key );
+    }
+
+    // Independent stream for a sub task, like a tile or a layer.
+    RandomStream Substream(uint64 index) const
+    {
+        RandomStream stream = *this;
+        stream.SetKey( Mix64( (((uint64)m_Key[1] << 32) | m_Key[0]) ^ Mix64( index ) ) );
+        return stream;
+    }
+
+    // Seed for nodes that don't want repeatable results.
+    static uint32 NonDeterministicSeed()
+    {
+        static std::random_device device;
+        return device();
+    }
+
+    // Random access, value number 'index' for a given item.
+    uint32 UIntAt(uint64 item, uint32 index = 0) const
+    {
+        uint32 counter[4] = { (uint32)item, (uint32)(item >> 32), index / 4, 0x80000000 };
+        uint32 out[4];
+        Philox4x32_10( counter, m_Key, out );
+        return out[index % 4];
+    }
+
+    float FloatAt(uint64 item, uint32 index, float min, float max) const
+    {
+        return min + (max - min) * ToFloat01( UIntAt( item, index ) );
+    }
+
+    // Sequential draws.
+    uint32 NextUInt()
+    {
+        if( m_NextInBlock == 4 )
+        {
+            uint32 counter[4] = { (uint32)m_NextBlock, (uint32)(m_NextBlock >> 32), 0, 0 };
+            Philox4x32_10( counter, m_Key, m_Block );
+            m_NextBlock++;
+            m_NextInBlock = 0;
+        }
+
+        return m_Block[m_NextInBlock++];
+    }
+
+    // [min, max)
+    float NextFloat(float min, float max)
+    {
+        return min + (max - min) * ToFloat01( NextUInt() );
+    }
+
+    // [min, max], inclusive.
+    size_t NextSizeT(size_t min, size_t max)
+    {
+        uint64 range = (uint64)(max - min) + 1;
+        // Separate statements, the order of the two calls in one expression isn't defined.
+        uint64 high = NextUInt();
+        uint64 low = NextUInt();
+        uint64 value = (high << 32) | low;
+        return min + (size_t)( range == 0 ? value : value % range );
+    }
+
+    // Top 24 bits to a float in [0, 1).
+    static inline float ToFloat01(uint32 value)
+    {
+        return (value >> 8) * (1.0f / 16777216.0f);
+    }
+};
+
+#endif //__RandomStream_H__
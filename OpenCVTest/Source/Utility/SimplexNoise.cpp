@@ -0,0 +1,164 @@
+//
+// Copyright (c) 2022 Jimmy Lord
+//
+#include "OpenCVPCH.h"
+#include "SimplexNoise.h"
+
+// Universal intrinsics aren't part of opencv.hpp, CV_SIMD is only defined once this is included.
+#include "opencv2/core/hal/intrin.hpp"
+
+static const float g_F2 = 0.36602540378f; // 0.5 * (sqrt(3) - 1)
+static const float g_G2 = 0.21132486540f; // (3 - sqrt(3)) / 6
+
+static const float g_GradX[12] = { 1, -1,  1, -1, 1, -1,  1, -1, 0,  0,  0,  0 };
+static const float g_GradY[12] = { 1,  1, -1, -1, 0,  0,  0,  0, 1, -1,  1, -1 };
+
+SimplexNoise2D::SimplexNoise2D(RandomStream stream)
+{
+    // Shuffle 0-255 and repeat it, so lookups of (index + perm[other index]) never need wrapping.
+    for( int i=0; i<256; i++ )
+    {
+        m_Perm[i] = i;
+    }
+
+    for( int i=255; i>0; i-- )
+    {
+        int swapIndex = (int)stream.NextSizeT( 0, i );
+        std::swap( m_Perm[i], m_Perm[swapIndex] );
+    }
+
+    for( int i=0; i<512; i++ )
+    {
+        m_Perm[i] = m_Perm[i & 255];
+        m_PermMod12[i] = m_Perm[i] % 12;
+    }
+}
+
+float SimplexNoise2D::Noise(float x, float y) const
+{
+    // Skew into simplex space to find the cell, then unskew the cell origin back.
+    float s = (x + y) * g_F2;
+    int i = (int)floorf( x + s );
+    int j = (int)floorf( y + s );
+    float t = (float)(i + j) * g_G2;
+    float x0 = x - ((float)i - t);
+    float y0 = y - ((float)j - t);
+
+    // Which of the two triangles we're in.
+    int i1 = x0 > y0 ? 1 : 0;
+    int j1 = 1 - i1;
+
+    float x1 = x0 - (float)i1 + g_G2;
+    float y1 = y0 - (float)j1 + g_G2;
+    float x2 = x0 - 1.0f + 2.0f*g_G2;
+    float y2 = y0 - 1.0f + 2.0f*g_G2;
+
+    int ii = i & 255;
+    int jj = j & 255;
+    int gi0 = m_PermMod12[ii + m_Perm[jj]];
+    int gi1 = m_PermMod12[ii + i1 + m_Perm[jj + j1]];
+    int gi2 = m_PermMod12[ii + 1 + m_Perm[jj + 1]];
+
+    // Contribution from each corner.
+    float t0 = std::max( 0.5f - x0*x0 - y0*y0, 0.0f );
+    t0 = t0*t0;
+    float n0 = t0*t0 * (g_GradX[gi0]*x0 + g_GradY[gi0]*y0);
+
+    float t1 = std::max( 0.5f - x1*x1 - y1*y1, 0.0f );
+    t1 = t1*t1;
+    float n1 = t1*t1 * (g_GradX[gi1]*x1 + g_GradY[gi1]*y1);
+
+    float t2 = std::max( 0.5f - x2*x2 - y2*y2, 0.0f );
+    t2 = t2*t2;
+    float n2 = t2*t2 * (g_GradX[gi2]*x2 + g_GradY[gi2]*y2);
+
+    return (n0 + n1 + n2) * 70.0f;
+}
+
+void SimplexNoise2D::NoiseRow(int startX, int count, float frequency, float offsetX, float y, float* output) const
+{
+    int i = 0;
+
+#if CV_SIMD
+    using namespace cv;
+
+    const int lanes = v_float32::nlanes;
+
+    int laneIndices[v_int32::nlanes];
+    for( int lane=0; lane<lanes; lane++ )
+        laneIndices[lane] = lane;
+
+    const v_int32 vLaneIndices = vx_load( laneIndices );
+    const v_int32 vOneInt = vx_setall_s32( 1 );
+    const v_int32 v255 = vx_setall_s32( 255 );
+    const v_float32 vZero = vx_setzero_f32();
+    const v_float32 vHalf = vx_setall_f32( 0.5f );
+    const v_float32 vOne = vx_setall_f32( 1.0f );
+    const v_float32 vF2 = vx_setall_f32( g_F2 );
+    const v_float32 vG2 = vx_setall_f32( g_G2 );
+    const v_float32 v2G2 = vx_setall_f32( 2.0f*g_G2 );
+    const v_float32 v70 = vx_setall_f32( 70.0f );
+    const v_float32 vFrequency = vx_setall_f32( frequency );
+    const v_float32 vOffsetX = vx_setall_f32( offsetX );
+    const v_float32 vy = vx_setall_f32( y );
+
+    // The tail is run as a full vector and only the needed lanes are kept, so every pixel goes through the same code.
+    float tail[v_float32::nlanes];
+    for( ; i < count; i += lanes )
+    {
+        v_float32 vx = v_cvt_f32( vx_setall_s32( startX + i ) + vLaneIndices ) * vFrequency + vOffsetX;
+
+        v_float32 s = (vx + vy) * vF2;
+        v_int32 ci = v_floor( vx + s );
+        v_int32 cj = v_floor( vy + s );
+        v_float32 t = v_cvt_f32( ci + cj ) * vG2;
+        v_float32 x0 = vx - (v_cvt_f32( ci ) - t);
+        v_float32 y0 = vy - (v_cvt_f32( cj ) - t);
+
+        v_int32 i1 = v_reinterpret_as_s32( x0 > y0 ) & vOneInt;
+        v_int32 j1 = vOneInt - i1;
+
+        v_float32 x1 = x0 - v_cvt_f32( i1 ) + vG2;
+        v_float32 y1 = y0 - v_cvt_f32( j1 ) + vG2;
+        v_float32 x2 = x0 - vOne + v2G2;
+        v_float32 y2 = y0 - vOne + v2G2;
+
+        v_int32 ii = ci & v255;
+        v_int32 jj = cj & v255;
+        v_int32 gi0 = v_lut( m_PermMod12, ii + v_lut( m_Perm, jj ) );
+        v_int32 gi1 = v_lut( m_PermMod12, ii + i1 + v_lut( m_Perm, jj + j1 ) );
+        v_int32 gi2 = v_lut( m_PermMod12, ii + vOneInt + v_lut( m_Perm, jj + vOneInt ) );
+
+        v_float32 t0 = v_max( vHalf - x0*x0 - y0*y0, vZero );
+        t0 = t0*t0;
+        v_float32 n0 = t0*t0 * (v_lut( g_GradX, gi0 )*x0 + v_lut( g_GradY, gi0 )*y0);
+
+        v_float32 t1 = v_max( vHalf - x1*x1 - y1*y1, vZero );
+        t1 = t1*t1;
+        v_float32 n1 = t1*t1 * (v_lut( g_GradX, gi1 )*x1 + v_lut( g_GradY, gi1 )*y1);
+
+        v_float32 t2 = v_max( vHalf - x2*x2 - y2*y2, vZero );
+        t2 = t2*t2;
+        v_float32 n2 = t2*t2 * (v_lut( g_GradX, gi2 )*x2 + v_lut( g_GradY, gi2 )*y2);
+
+        v_float32 result = (n0 + n1 + n2) * v70;
+
+        if( i + lanes <= count )
+        {
+            v_store( output + i, result );
+        }
+        else
+        {
+            v_store( tail, result );
+            for( int lane=0; i+lane<count; lane++ )
+                output[i+lane] = tail[lane];
+        }
+    }
+    vx_cleanup();
+#endif
+
+    for( ; i < count; i++ )
+    {
+        output[i] = Noise( (float)(startX + i) * frequency + offsetX, y );
+    }
+}
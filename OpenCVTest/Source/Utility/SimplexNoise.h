@@ -0,0 +1,28 @@
+//
+// Copyright (c) 2022 Jimmy Lord
+//
+#ifndef __SimplexNoise_H__
+#define __SimplexNoise_H__
+
+#include "RandomStream.h"
+
+// 2D simplex noise, based on Stefan Gustavson's "Simplex noise demystified".
+// https://weber.itn.liu.se/~stegu/simplexnoise/simplexnoise.pdf
+// Rows are evaluated several pixels at a time with OpenCV's universal intrinsics, single floats are
+//   evaluated with the same sequence of operations in plain C++. Results are in roughly [-1, 1].
+class SimplexNoise2D
+{
+protected:
+    int m_Perm[512];
+    int m_PermMod12[512];
+
+public:
+    SimplexNoise2D(RandomStream stream);
+
+    float Noise(float x, float y) const;
+
+    // output[i] = Noise( (startX + i) * frequency + offsetX, y ) for i in [0, count).
+    void NoiseRow(int startX, int count, float frequency, float offsetX, float y, float* output) const;
+};
+
+#endif //__SimplexNoise_H__